@@ -0,0 +1,180 @@
+#include "algebra.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <climits>
+
+/*
+	Exponent of a power of two between 2 and 2^30, 0 otherwise
+*/
+static int log2Of(int v)
+{
+	if(v<2||v&(v-1))return 0;
+	int k=0;
+	while(v>1){
+		v>>=1;
+		k++;
+	}
+	return k;
+}
+
+/*
+	Literal operand of a value
+*/
+static bool is(Var*v,int val)
+{
+	return v&&v->isLiteral()&&v->getVal()==val;
+}
+
+AlgebraicSimplify::AlgebraicSimplify(Fun*fun,SymTab*tab):fun(fun),tab(tab),identities(0),muls(0),divs(0),mods(0)
+{
+}
+
+/*
+	Literal variable
+*/
+Var* AlgebraicSimplify::literal(int val)
+{
+	unordered_map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	New int temporary, declared by the caller
+*/
+Var* AlgebraicSimplify::temp(Var*res)
+{
+	Var*t=new Var(res->getPath(),KW_INT,false);
+	tab->AddTemp(t);
+	return t;
+}
+
+/*
+	t=x plus 2^k-1 when x is negative, so that the shift right rounds
+	towards zero like the division
+*/
+void AlgebraicSimplify::bias(vector<InterInst*>&out,Var*t,Var*x,int k)
+{
+	if(k==1)out.push_back(new InterInst(OP_SHR,t,x,literal(31)));
+	else{
+		out.push_back(new InterInst(OP_SAR,t,x,literal(31)));
+		out.push_back(new InterInst(OP_SHR,t,t,literal(32-k)));
+	}
+	out.push_back(new InterInst(OP_ADD,t,x,t));
+}
+
+/*
+	Simplify one instruction in place, or append the instructions replacing
+	it to out. Returns true if it was rewritten.
+*/
+bool AlgebraicSimplify::rewrite(InterInst*inst,vector<InterInst*>&out,vector<Var*>&temps)
+{
+	Operator op=inst->getOp();
+	Var*r=inst->getResult(),*a=inst->getArg1(),*b=inst->getArg2();
+	if(op<OP_ADD||op>OP_MOD)return false;
+	if(a->isLiteral()&&b->isLiteral())return false;//left to constant propagation
+	if(op==OP_ADD||op==OP_MUL){//commutative: the literal goes second
+		if(a->isLiteral()){
+			Var*t=a;
+			a=b;
+			b=t;
+		}
+	}
+	int k=b->isLiteral()?log2Of(b->getVal()):0;
+	switch(op){
+		case OP_ADD:
+			if(!is(b,0))return false;
+			inst->replace(OP_AS,r,a);
+			break;
+		case OP_SUB:
+			if(is(b,0))inst->replace(OP_AS,r,a);
+			else if(is(a,0))inst->replace(OP_NEG,r,b);
+			else if(a==b)inst->replace(OP_AS,r,literal(0));
+			else return false;
+			break;
+		case OP_MUL:
+			if(is(b,0))inst->replace(OP_AS,r,literal(0));
+			else if(is(b,1))inst->replace(OP_AS,r,a);
+			else if(is(b,-1))inst->replace(OP_NEG,r,a);
+			else if(k){
+				inst->replace(OP_SHL,r,a,literal(k));
+				muls++;
+				return true;
+			}
+			else return false;
+			break;
+		case OP_DIV:
+			if(is(b,1))inst->replace(OP_AS,r,a);
+			else if(is(b,-1))inst->replace(OP_NEG,r,a);
+			else if(k){
+				Var*t=temp(r);
+				temps.push_back(t);
+				bias(out,t,a,k);
+				out.push_back(new InterInst(OP_SAR,r,t,literal(k)));
+				delete inst;
+				divs++;
+				return true;
+			}
+			else return false;
+			break;
+		default://OP_MOD, x%-2^k is x%2^k
+			if(is(b,1)||is(b,-1))inst->replace(OP_AS,r,literal(0));
+			else{
+				if(b->isLiteral()&&b->getVal()<0&&b->getVal()!=INT_MIN)k=log2Of(-b->getVal());
+				if(!k)return false;
+				Var*t=temp(r);
+				temps.push_back(t);
+				bias(out,t,a,k);
+				out.push_back(new InterInst(OP_BAND,t,t,literal(-(1<<k))));
+				out.push_back(new InterInst(OP_SUB,r,a,t));
+				delete inst;
+				mods++;
+				return true;
+			}
+	}
+	identities++;
+	return true;
+}
+
+/*
+	执行代数化简
+*/
+void AlgebraicSimplify::simplify()
+{
+	vector<InterInst*>&code=fun->getCode();
+	vector<InterInst*>out;
+	vector<Var*>temps;
+	out.reserve(code.size());
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()){
+			out.push_back(inst);
+			continue;
+		}
+		vector<InterInst*>seq;
+		if(!rewrite(inst,seq,temps)||seq.empty())out.push_back(inst);
+		else out.insert(out.end(),seq.begin(),seq.end());
+	}
+	if(!temps.empty()){
+		vector<InterInst*>decs;
+		for(int t=0;t<temps.size();t++)decs.push_back(new InterInst(OP_DEC,temps[t]));
+		out.insert(out.begin()+1,decs.begin(),decs.end());//after the entry
+	}
+	code.swap(out);
+	if(Args::stats)
+		fprintf(stderr,"%s: algebraic simplification %d identities, %d multiplications, %d divisions, %d modulos\n",
+			fun->getName().c_str(),identities,muls,divs,mods);
+}
+
+/*
+	Instructions rewritten
+*/
+int AlgebraicSimplify::getSimplified()
+{
+	return identities+muls+divs+mods;
+}
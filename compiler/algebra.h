@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+class Var;
+class Fun;
+class SymTab;
+class InterInst;
+
+/*
+	Algebraic simplification of the arithmetic with a literal operand.
+	Identities become copies or negations: x+0, x-0, 0-x, x-x, x*0, x*1,
+	x*-1, x/1, x/-1, x%1 and x%-1. Multiplication by a power of two
+	becomes a left shift, signed division and modulo by a power of two
+	become shifts and masks with a bias for negative dividends:
+		t=x>>31; t=t>>>(32-k); t=x+t; r=t>>k	(r=x/2^k)
+		t=x>>31; t=t>>>(32-k); t=x+t; t=t&-2^k; r=x-t	(r=x%2^k)
+	Runs after strength reduction, which looks for the multiplications.
+*/
+class AlgebraicSimplify
+{
+	Fun*fun;
+	SymTab*tab;
+	int identities;//identities rewritten
+	int muls;//multiplications turned into shifts
+	int divs;//divisions turned into shifts
+	int mods;//modulos turned into masks
+	unordered_map<int,Var*>literals;//literals created
+
+	Var*literal(int val);//literal variable
+	Var*temp(Var*res);//new int temporary
+	void bias(vector<InterInst*>&out,Var*t,Var*x,int k);//t=x+(x<0?2^k-1:0)
+	bool rewrite(InterInst*inst,vector<InterInst*>&out,vector<Var*>&temps);//simplify one instruction
+public:
+	AlgebraicSimplify(Fun*fun,SymTab*tab);
+
+	void simplify();//执行代数化简
+	int getSimplified();//instructions rewritten
+};
@@ -0,0 +1,128 @@
+#include "args.h"
+#include "passManager.h"
+#include "regAlloc.h"
+#include <string.h>
+
+string Args::srcFile="";
+bool Args::emitIr=true;
+bool Args::emitAsm=true;
+int Args::opt=0;
+int Args::regAlloc=-1;
+bool Args::stream=false;
+bool Args::stats=false;
+bool Args::showBlock=false;
+bool Args::showFlow=false;
+bool Args::timeFlow=false;
+bool Args::timePasses=false;
+
+/*
+	Parse the --emit=ir,asm output selector
+*/
+static bool parseEmit(const char*list)
+{
+	Args::emitIr=false;
+	Args::emitAsm=false;
+	string items=list;
+	size_t start=0;
+	while(start<=items.size()){
+		size_t end=items.find(',',start);
+		if(end==string::npos)end=items.size();
+		string item=items.substr(start,end-start);
+		if(item=="ir")Args::emitIr=true;
+		else if(item=="asm")Args::emitAsm=true;
+		else{
+			printf("unknown output kind '%s' in --emit\n",item.c_str());
+			return false;
+		}
+		start=end+1;
+	}
+	return true;
+}
+
+/*
+	Parse arguments, false on error
+*/
+bool Args::parse(int argc,char*argv[])
+{
+	bool passes=false;//--passes given
+	for(int i=1;i<argc;i++){
+		const char*arg=argv[i];
+		if(!strncmp(arg,"--emit=",7)){
+			if(!parseEmit(arg+7))return false;
+		}
+		else if(!strcmp(arg,"-O")||!strcmp(arg,"-O0")||!strcmp(arg,"-O1")||!strcmp(arg,"-O2")){
+			opt=arg[2]?arg[2]-'0':1;
+		}
+		else if(!strncmp(arg,"--passes=",9)){
+			if(!PassManager::select(arg+9))return false;
+			passes=true;
+		}
+		else if(!strncmp(arg,"--regalloc=",11)){
+			const char*kind=arg+11;
+			if(!strcmp(kind,"none"))regAlloc=ALLOC_NONE;
+			else if(!strcmp(kind,"linear"))regAlloc=ALLOC_LINEAR;
+			else if(!strcmp(kind,"color"))regAlloc=ALLOC_COLOR;
+			else{
+				printf("unknown register allocator '%s'\n",kind);
+				return false;
+			}
+		}
+		else if(!strcmp(arg,"--stream")){
+			stream=true;
+		}
+		else if(!strcmp(arg,"--stats")){
+			stats=true;
+		}
+		else if(!strcmp(arg,"--show-blocks")){
+			showBlock=true;
+		}
+		else if(!strcmp(arg,"--show-dataflow")){
+			showFlow=true;
+		}
+		else if(!strcmp(arg,"--time-dataflow")){
+			timeFlow=true;
+		}
+		else if(!strcmp(arg,"--time-passes")){
+			timePasses=true;
+		}
+		else if(arg[0]=='-'){
+			printf("unknown option '%s'\n",arg);
+			return false;
+		}
+		else if(srcFile==""){
+			srcFile=arg;
+		}
+		else{
+			printf("only one source file is supported\n");
+			return false;
+		}
+	}
+	if(passes&&!opt)opt=1;//the list runs at any level
+	return srcFile!="";
+}
+
+/*
+	Print usage
+*/
+void Args::usage(const char*exe)
+{
+	printf("usage: %s [options] file.c\n",exe);
+	printf("  --emit=ir,asm    outputs to generate (default: ir,asm)\n");
+	printf("  -O0 -O1 -O2      optimization level (default: -O0, -O means -O1)\n");
+	printf("  --passes=a,b,... run these optimization passes in order instead of the\n");
+	printf("                   pipeline of the level, a pass may be repeated\n");
+	printf("  --regalloc=none|linear|color\n");
+	printf("                   register allocator (default: none at -O0, linear scan at -O1,\n");
+	printf("                   graph coloring with copy coalescing at -O2)\n");
+	printf("  --stream         emit each function when its definition ends and free its code,\n");
+	printf("                   global data is written after the last function\n");
+	printf("  --stats          print per function statistics to stderr\n");
+	printf("  --show-blocks    print basic blocks, dominators and loops of every function\n");
+	printf("  --show-dataflow  print live variables, reaching definitions and available\n");
+	printf("                   expressions of every block\n");
+	printf("  --time-dataflow  solve the dataflow analyses of every function and print\n");
+	printf("                   their size and cost to stderr\n");
+	printf("  --time-passes    print the time and code size of every optimization pass\n");
+	printf("                   to stderr, with the totals per pass at the end\n");
+	PassManager::usage();
+}
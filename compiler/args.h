@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+
+/*
+	Command line arguments
+*/
+class Args
+{
+public:
+	static string srcFile;//source file to compile
+	static bool emitIr;//write intermediate code file(.ir)
+	static bool emitAsm;//write assembly file(.s)
+	static int opt;//optimization level, 0 disables the optimizer
+	static int regAlloc;//register allocator: -1 by the level, ALLOC_NONE, ALLOC_LINEAR or ALLOC_COLOR
+	static bool stream;//emit and free every function as soon as it is defined
+	static bool stats;//print per function statistics to stderr
+	static bool showBlock;//print basic blocks, dominators and loops
+	static bool showFlow;//print liveness, reaching definitions and available expressions
+	static bool timeFlow;//solve the dataflow analyses and report their cost to stderr
+	static bool timePasses;//report the time and code size of every optimization pass to stderr
+
+	static bool parse(int argc,char*argv[]);//parse arguments, false on error
+	static void usage(const char*exe);//print usage
+};
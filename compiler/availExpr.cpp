@@ -0,0 +1,233 @@
+#include "availExpr.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+
+/*
+	Order of expressions for the lookup map
+*/
+bool AvailExpr::Expr::operator<(const Expr&e) const
+{
+	if(op!=e.op)return op<e.op;
+	if(arg1!=e.arg1)return arg1<e.arg1;
+	return arg2<e.arg2;
+}
+
+/*
+	Number the expressions, then compute gen (expressions computed and not
+	killed later in the block) and kill of every block and solve
+*/
+AvailExpr::AvailExpr(DFG*dfg,vector<InterInst*>&code)
+	:DataFlow(dfg,FORWARD,INTERSECT),vars(code),alias(vars,code),clock(0),start(0),lastUnknown(-1),lastMemDef(-1)
+{
+	varExprs.resize(vars.size());
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(!isCandidate(inst))continue;
+		Expr e={inst->getOp(),inst->getArg1(),inst->getArg2()};
+		map<Expr,int>::iterator it=exprMap.find(e);
+		if(it!=exprMap.end()){
+			instExpr[inst]=it->second;
+			continue;
+		}
+		int id=exprs.size();
+		exprMap[e]=id;
+		instExpr[inst]=id;
+		exprs.push_back(e);
+		if(VarIndex::tracked(e.arg1))varExprs[e.arg1->index].push_back(id);
+		if(VarIndex::tracked(e.arg2)&&e.arg2!=e.arg1)varExprs[e.arg2->index].push_back(id);
+	}
+	//an array operand is a fixed address, not a memory read
+	memExprs.init(exprs.size(),false);
+	loadExprs.init(exprs.size(),false);
+	for(int i=0;i<exprs.size();i++){
+		Expr&e=exprs[i];
+		Var*args[2]={e.arg1,e.arg2};
+		bool mem=e.op==OP_GET;
+		for(int k=0;k<2;k++)
+			if(VarIndex::tracked(args[k])&&alias.isEscaped(args[k])&&!args[k]->getArray())mem=true;
+		if(e.op==OP_GET)loadExprs.set(i);
+		if(mem)memExprs.set(i);
+	}
+	computed.assign(exprs.size(),-1);
+	defined.assign(vars.size(),-1);
+	killedIn.assign(vars.size(),-1);
+	if(!init(exprs.size()))return;
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		Set&g=gen[b->id];
+		start=++clock;
+		for(int j=0;j<b->insts.size();j++)step(b->insts[j]);
+		for(int j=0;j<b->insts.size();j++){
+			int e=getExpr(b->insts[j]);
+			if(e>=0&&isAvail(e))g.set(e);
+		}
+		addKills(b);
+	}
+	solve(Set(exprs.size()));
+}
+
+/*
+	Kill set of a block: the expressions reading a variable it defines, a
+	call writes or a store may write through a known pointer, loads if it
+	writes a memory variable and every read of escaped memory if it has a
+	call with unknown effects or a store through a wild pointer
+*/
+void AvailExpr::addKills(Block*b)
+{
+	Set&killed=kill[b->id];
+	bool unknown=false,memDef=false;
+	for(int i=0;i<b->insts.size();i++){
+		InterInst*inst=b->insts[i];
+		Var*def=inst->getDef();
+		if(VarIndex::tracked(def)&&killedIn[def->index]!=b->id){
+			killedIn[def->index]=b->id;//once per block
+			vector<int>&users=varExprs[def->index];
+			for(int j=0;j<users.size();j++)killed.set(users[j]);
+			if(vars.isMem(def))memDef=true;
+		}
+		vector<Var*>&writes=inst->getWrites();//globals written by the callee
+		for(int k=0;k<writes.size();k++){
+			killReaders(writes[k],b);
+			memDef=true;
+		}
+		if(inst->getOp()==OP_SET){
+			Set&to=alias.getTargets(inst->getArg1());
+			for(int o=to.next(0);o!=-1;o=to.next(o+1))killReaders(alias.getObj(o),b);
+			if(alias.isWild(inst->getArg1()))unknown=true;
+			memDef=true;
+		}
+		else if(inst->unknown())unknown=true;
+	}
+	if(memDef)killed.unite(loadExprs);
+	if(unknown)killed.unite(memExprs);
+}
+
+/*
+	Add the expressions reading a variable written through memory to the
+	kill set of b, once per block
+*/
+void AvailExpr::killReaders(Var*var,Block*b)
+{
+	if(!vars.has(var)||var->getArray()||killedIn[var->index]==b->id)return;
+	killedIn[var->index]=b->id;
+	vector<int>&users=varExprs[var->index];
+	for(int j=0;j<users.size();j++)kill[b->id].set(users[j]);
+}
+
+/*
+	Instruction computes an expression: arithmetic, comparison or load
+*/
+bool AvailExpr::isCandidate(InterInst*inst)
+{
+	Operator op=inst->getOp();
+	return !inst->isLb()&&(op>=OP_ADD&&op<=OP_OR||op==OP_GET);
+}
+
+/*
+	Expression index of inst, -1 if none
+*/
+int AvailExpr::getExpr(InterInst*inst)
+{
+	unordered_map<InterInst*,int>::iterator it=instExpr.find(inst);
+	return it==instExpr.end()?-1:it->second;
+}
+
+/*
+	Number of expressions
+*/
+int AvailExpr::getCount()
+{
+	return exprs.size();
+}
+
+/*
+	Last definition of an operand in the walk, -1 for literals
+*/
+int AvailExpr::defTime(Var*var)
+{
+	return VarIndex::tracked(var)?defined[var->index]:-1;
+}
+
+/*
+	Start a walk of b: the expressions available on entry count as
+	computed at the start, everything before is stale
+*/
+void AvailExpr::enter(Block*b)
+{
+	start=++clock;
+	Set&in=getIn(b);
+	for(int e=in.next(0);e!=-1;e=in.next(e+1))computed[e]=start;
+}
+
+/*
+	Expression available at the current point of the walk: computed in
+	this block (or on entry) after the last kill
+*/
+bool AvailExpr::isAvail(int e)
+{
+	int t=computed[e];
+	Expr&x=exprs[e];
+	return t>=start&&t>defTime(x.arg1)&&t>defTime(x.arg2)
+		&&(!memExprs.get(e)||t>lastUnknown)&&(!loadExprs.get(e)||t>lastMemDef);
+}
+
+/*
+	Walk over inst: its expression is computed, then its definition and
+	side effects kill
+*/
+void AvailExpr::step(InterInst*inst)
+{
+	int t=++clock;
+	int e=getExpr(inst);
+	if(e>=0)computed[e]=t;
+	Var*def=inst->getDef();
+	if(VarIndex::tracked(def)){
+		defined[def->index]=t;
+		if(vars.isMem(def))lastMemDef=t;
+	}
+	vector<Var*>&writes=inst->getWrites();
+	for(int k=0;k<writes.size();k++){
+		if(vars.has(writes[k]))defined[writes[k]->index]=t;
+		lastMemDef=t;
+	}
+	if(!inst->isLb()&&inst->getOp()==OP_SET){
+		Set&to=alias.getTargets(inst->getArg1());
+		for(int o=to.next(0);o!=-1;o=to.next(o+1))
+			if(!alias.getObj(o)->getArray())defined[alias.getObj(o)->index]=t;
+		if(alias.isWild(inst->getArg1()))lastUnknown=t;
+		lastMemDef=t;
+	}
+	else if(inst->unknown())lastUnknown=t;
+}
+
+/*
+	Expression text
+*/
+string AvailExpr::toString(int e)
+{
+	static const char*ops[]={"+","-","*","/","%","-","<<",">>",">>>","&","|","^",">",">=","<","<=","==","!=","!","&&","||"};
+	Expr&x=exprs[e];
+	if(x.op==OP_GET)return "*"+x.arg1->valueStr();
+	if(x.op==OP_NEG||x.op==OP_NOT)return ops[x.op-OP_ADD]+x.arg1->valueStr();
+	return x.arg1->valueStr()+ops[x.op-OP_ADD]+x.arg2->valueStr();
+}
+
+/*
+	Print available in and out of every block
+*/
+void AvailExpr::toString()
+{
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int k=0;k<2;k++){
+			Set&s=k?getOut(b):getIn(b);
+			printf("B%d avail %s:",b->id,k?"out":"in");
+			for(int e=s.next(0);e!=-1;e=s.next(e+1))
+				printf(" %s",toString(e).c_str());
+			printf("\n");
+		}
+	}
+}
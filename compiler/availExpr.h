@@ -0,0 +1,62 @@
+#pragma once
+
+#include "dataFlow.h"
+#include "pointsTo.h"
+#include <map>
+#include <unordered_map>
+
+/*
+	Available expressions, a forward intersection problem over the
+	distinct (op,arg1,arg2) computations of a function. Redefining an
+	operand kills an expression; a store kills the expressions reading
+	the variables its pointer may point to and the loads, a store through
+	a wild pointer or a call every expression reading escaped memory (see
+	PointsTo), a write to a memory variable kills the loads. A call with
+	a known summary only writes the globals it lists.
+	Walks inside a block use time stamps instead of sets, so a definition
+	costs the same however many expressions read the variable.
+*/
+class AvailExpr:public DataFlow
+{
+	//a computation, operands compared by identity
+	struct Expr
+	{
+		Operator op;
+		Var*arg1;
+		Var*arg2;
+		bool operator<(const Expr&e) const;
+	};
+
+	VarIndex vars;
+	PointsTo alias;//targets of the stores
+	vector<Expr>exprs;//expressions by index
+	map<Expr,int>exprMap;//expression -> index
+	unordered_map<InterInst*,int>instExpr;//expression computed by an instruction
+	vector<vector<int> >varExprs;//expressions reading every variable
+	Set memExprs;//expressions reading escaped memory: loads and escaped variable operands
+	Set loadExprs;//loads
+	vector<int>killedIn;//last block whose kill set has the readers of every variable
+
+	//walk state
+	int clock;//time of the last instruction walked
+	int start;//time the current block was entered
+	vector<int>computed;//last time every expression was computed
+	vector<int>defined;//last time every variable was defined
+	int lastUnknown;//last call or store through a wild pointer
+	int lastMemDef;//last write to a memory variable
+
+	int defTime(Var*var);//last definition of an operand, -1 for literals
+	void addKills(Block*b);//kill set of a block
+	void killReaders(Var*var,Block*b);//kill the readers of a variable written through memory
+public:
+	AvailExpr(DFG*dfg,vector<InterInst*>&code);
+
+	static bool isCandidate(InterInst*inst);//instruction computes an expression
+	int getExpr(InterInst*inst);//expression index of inst, -1 if none
+	int getCount();//number of expressions
+	void enter(Block*b);//start a walk of b with its available expressions
+	bool isAvail(int e);//expression available at the current point of the walk
+	void step(InterInst*inst);//walk over inst
+	string toString(int e);//expression text
+	void toString();//print available in and out of every block
+};
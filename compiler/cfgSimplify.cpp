@@ -0,0 +1,362 @@
+#include "cfgSimplify.h"
+#include "symbol.h"
+#include "interCode.h"
+#include "genIr.h"
+#include "dfg.h"
+#include "args.h"
+
+/*
+	Outcomes of a comparison a conditional jump is taken for: 1 less,
+	2 equal, 4 greater
+*/
+static int relation(Operator op)
+{
+	switch(op){
+		case OP_JT:case OP_JNE:return 5;
+		case OP_JF:case OP_JE:return 2;
+		case OP_JG:return 4;
+		case OP_JGE:return 6;
+		case OP_JL:return 1;
+		default:return 3;//OP_JLE
+	}
+}
+
+/*
+	Same operand of a test, the missing second operand of JT and JF is 0
+*/
+static bool same(Var*a,Var*b)
+{
+	if(a==b)return true;
+	int x=0,y=0;
+	if(a){
+		if(!a->isLiteral())return false;
+		x=a->getVal();
+	}
+	if(b){
+		if(!b->isLiteral())return false;
+		y=b->getVal();
+	}
+	return x==y;
+}
+
+CfgSimplify::CfgSimplify(Fun*fun):fun(fun),rounds(0),threaded(0),decided(0),dropped(0),merged(0),removed(0)
+{
+}
+
+/*
+	Label positions and the number of jumps to each label
+*/
+void CfgSimplify::index()
+{
+	vector<InterInst*>&code=fun->getCode();
+	pos.clear();
+	refs.clear();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()){
+			pos[inst]=i;
+			continue;
+		}
+		if(inst->isJmp()||inst->isJcond())refs[inst->getTarget()]++;
+		vector<InterInst*>&table=inst->getTable();
+		for(int k=0;k<table.size();k++)refs[table[k]]++;
+	}
+}
+
+/*
+	First instruction from i that does something: labels, removed
+	instructions and declarations without value are passed
+*/
+int CfgSimplify::skip(int i)
+{
+	vector<InterInst*>&code=fun->getCode();
+	for(;i<code.size()-1;i++){
+		InterInst*inst=code[i];
+		if(!inst->isLb()&&!inst->isDead&&(inst->getOp()!=OP_DEC||!inst->getArg1()->unInit()))break;
+	}
+	return i;
+}
+
+/*
+	End of the chain of unconditional jumps starting at lb
+*/
+InterInst* CfgSimplify::final(InterInst*lb)
+{
+	vector<InterInst*>&code=fun->getCode();
+	for(int n=0;n<CFG_CHAIN&&pos.count(lb);n++){
+		InterInst*inst=code[skip(pos[lb])];
+		if(inst->isLb()||inst->getOp()!=OP_JMP||inst->getTarget()==lb)break;
+		lb=inst->getTarget();
+	}
+	return lb;
+}
+
+/*
+	Outcome of the test b right after the test a was taken or not, with
+	nothing run between: 1 taken, 0 not taken, -1 unknown. Both have to
+	compare the same operands, in either order.
+*/
+int CfgSimplify::implied(InterInst*a,bool taken,InterInst*b)
+{
+	if(b->isLb()||b->isDead||!b->isJcond())return -1;
+	int ma=relation(a->getOp()),mb=relation(b->getOp());
+	int fact=taken?ma:7&~ma;
+	Var*a1=a->getArg1(),*a2=a->getArg2(),*b1=b->getArg1(),*b2=b->getArg2();
+	if(!same(a1,b1)||!same(a2,b2)){
+		if(!same(a1,b2)||!same(a2,b1))return -1;
+		fact=(fact&2)|(fact&1)<<2|(fact&4)>>2;//a<b is b>a
+	}
+	if(!(fact&~mb))return 1;
+	if(!(fact&mb))return 0;
+	return -1;
+}
+
+/*
+	Retarget a jump keeping the uses of the labels
+*/
+void CfgSimplify::redirect(InterInst*inst,Operator op,InterInst*to,Var*arg1,Var*arg2)
+{
+	refs[inst->getTarget()]--;
+	refs[to]++;
+	inst->replace(op,to,arg1,arg2);
+}
+
+/*
+	Thread the jumps: through empty blocks ending with a jump, into the
+	returns they reach, and past the tests decided by the outcome of a
+	conditional jump. A test not taken continues after itself, a label is
+	added there when it has none.
+*/
+bool CfgSimplify::thread()
+{
+	vector<InterInst*>&code=fun->getCode();
+	unordered_map<int,InterInst*>after;//index of a test -> new label after it
+	int before=threaded+decided;
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->isDead)continue;
+		Operator op=inst->getOp();
+		InterInst*to=inst->getTarget();
+		if(op==OP_JMP){
+			InterInst*t=final(to);
+			InterInst*ret=pos.count(t)?code[skip(pos[t])]:NULL;
+			if(ret&&!ret->isLb()&&(ret->getOp()==OP_RET||ret->getOp()==OP_RETV)){
+				redirect(inst,ret->getOp(),ret->getTarget(),ret->getArg1(),NULL);
+				threaded++;
+			}
+			else if(t!=to){
+				redirect(inst,OP_JMP,t,NULL,NULL);
+				threaded++;
+			}
+		}
+		else if(op==OP_JTAB){
+			vector<InterInst*>&table=inst->getTable();
+			for(int k=0;k<table.size();k++){
+				InterInst*t=final(table[k]);
+				if(t==table[k])continue;
+				refs[table[k]]--;
+				refs[t]++;
+				table[k]=t;
+				threaded++;
+			}
+			InterInst*t=final(to);
+			if(t!=to){
+				redirect(inst,OP_JTAB,t,inst->getArg1(),inst->getArg2());
+				threaded++;
+			}
+		}
+		else if(inst->isJcond()){
+			//taken: on through empty jumps and the tests it decides
+			InterInst*t=final(to);
+			for(int n=0;n<CFG_CHAIN&&pos.count(t);n++){
+				int j=skip(pos[t]);
+				int known=implied(inst,true,code[j]);
+				if(known<0||code[j]==inst)break;
+				decided++;
+				if(known)t=final(code[j]->getTarget());
+				else if(code[j+1]->isLb())t=code[j+1];
+				else{
+					InterInst*&lb=after[j];
+					if(!lb)lb=new InterInst();
+					t=lb;
+				}
+			}
+			if(t!=to){
+				redirect(inst,op,t,inst->getArg1(),inst->getArg2());
+				threaded++;
+			}
+			//not taken: the next test is decided when nothing else reaches it
+			int k=i+1;
+			bool alone=true;
+			for(;k<code.size()-1;k++){
+				InterInst*c=code[k];
+				if(c->isLb()){
+					if(refs[c])alone=false;
+				}
+				else if(!c->isDead&&(c->getOp()!=OP_DEC||!c->getArg1()->unInit()))break;
+			}
+			int known=alone?implied(inst,false,code[k]):-1;
+			if(known==1)code[k]->replace(OP_JMP,code[k]->getTarget());
+			else if(known==0){
+				refs[code[k]->getTarget()]--;
+				code[k]->isDead=true;
+			}
+			if(known>=0)decided++;
+		}
+	}
+	if(!after.empty()){
+		vector<InterInst*>out;
+		out.reserve(code.size()+after.size());
+		for(int i=0;i<code.size();i++){
+			out.push_back(code[i]);
+			unordered_map<int,InterInst*>::iterator lb=after.find(i);
+			if(lb!=after.end())out.push_back(lb->second);
+		}
+		code.swap(out);
+	}
+	return threaded+decided>before;
+}
+
+/*
+	Remove the jumps to the next instruction, and invert a conditional
+	jump over a jump: if(a)goto A; goto B; A: => if(!a)goto B; A:
+*/
+bool CfgSimplify::drop()
+{
+	vector<InterInst*>&code=fun->getCode();
+	int before=dropped;
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->isDead)continue;
+		Operator op=inst->getOp();
+		if(op!=OP_JMP&&op!=OP_RET&&!inst->isJcond())continue;
+		InterInst*to=inst->getTarget();
+		int k=skip(i+1);
+		if(pos[to]>i&&pos[to]<=k){
+			refs[to]--;
+			inst->isDead=true;
+			dropped++;
+			continue;
+		}
+		if(!inst->isJcond())continue;
+		InterInst*jmp=code[i+1];
+		if(jmp->isLb()||jmp->getOp()!=OP_JMP)continue;
+		for(k=i+2;k<code.size()-1&&code[k]!=to&&code[k]->isLb();k++);
+		if(code[k]!=to)continue;
+		refs[to]--;
+		inst->replace(GenIR::inverse(op),jmp->getTarget(),inst->getArg1(),inst->getArg2());
+		jmp->isDead=true;
+		dropped++;
+	}
+	return dropped>before;
+}
+
+/*
+	Remove the code after a jump up to the next label in use, declarations
+	excepted, and the labels no jump uses
+*/
+bool CfgSimplify::unreachable()
+{
+	vector<InterInst*>&code=fun->getCode();
+	int before=removed;
+	bool reached=true;//reached by falling into it
+	for(int i=1;i<code.size()-1;i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()){
+			if(refs[inst])reached=true;
+			else{
+				inst->isDead=true;
+				removed++;
+			}
+			continue;
+		}
+		if(reached){
+			if(inst->isJmp())reached=false;
+			continue;
+		}
+		if(inst->getOp()==OP_DEC)continue;
+		if(inst->isJmp()||inst->isJcond())refs[inst->getTarget()]--;
+		vector<InterInst*>&table=inst->getTable();
+		for(int k=0;k<table.size();k++)refs[table[k]]--;
+		inst->isDead=true;
+		removed++;
+	}
+	return removed>before;
+}
+
+/*
+	Move a block reached by one jump only, and not by falling into it, in
+	place of that jump when it ends with a jump itself. Blocks declaring
+	variables stay where they are.
+*/
+bool CfgSimplify::merge()
+{
+	vector<InterInst*>&code=fun->getCode();
+	int n=code.size();
+	vector<int>first(n,-1),last(n,-1);//jump -> range of the block moving to it
+	vector<char>taken(n,0);//part of a move
+	int before=merged;
+	for(int i=1;i<n-1;i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->getOp()!=OP_JMP||taken[i])continue;
+		InterInst*lb=inst->getTarget();
+		int p=pos[lb];
+		if(refs[lb]!=1||code[p-1]->isLb()||!code[p-1]->isJmp())continue;
+		int e=p+1;
+		while(e<n-1&&!code[e]->isLb()&&code[e]->getOp()!=OP_DEC&&!code[e]->isJmp())e++;
+		if(e>=n-1||!code[e]->isJmp()||code[e]->isLb()||i>=p&&i<=e)continue;
+		bool free=true;
+		for(int k=p;free&&k<=e;k++)free=!taken[k];
+		if(!free)continue;
+		for(int k=p;k<=e;k++)taken[k]=1;
+		taken[i]=1;
+		first[i]=p;
+		last[i]=e;
+		merged++;
+	}
+	if(merged==before)return false;
+	vector<InterInst*>out;
+	out.reserve(n);
+	for(int i=0;i<n;i++){
+		if(first[i]>=0){//the jump and the label go, the block takes their place
+			out.insert(out.end(),code.begin()+first[i]+1,code.begin()+last[i]+1);
+			delete code[first[i]];
+			delete code[i];
+		}
+		else if(!taken[i])out.push_back(code[i]);
+	}
+	code.swap(out);
+	return true;
+}
+
+/*
+	执行控制流图化简：rounds until nothing changes, then the cycles no path
+	from the entry reaches go too
+*/
+void CfgSimplify::simplify()
+{
+	InterCode&code=fun->getInterCode();
+	bool changed=true;
+	while(changed&&rounds<CFG_ROUNDS){
+		rounds++;
+		index();
+		changed=thread();
+		code.removeDead();
+		index();
+		changed|=drop();
+		code.removeDead();
+		index();
+		changed|=unreachable();
+		code.removeDead();
+		index();
+		changed|=merge();
+	}
+	{
+		DFG dfg(code);
+		removed+=dfg.markUnreachable();
+	}
+	code.removeDead();
+	if(Args::stats)
+		fprintf(stderr,"%s: cfg simplification threaded %d jumps, decided %d tests, dropped %d jumps, merged %d blocks, removed %d in %d rounds\n",
+			fun->getName().c_str(),threaded,decided,dropped,merged,removed,rounds);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+#define CFG_ROUNDS 8//rounds until the code stops changing
+#define CFG_CHAIN 16//jumps followed to thread one jump
+
+class Fun;
+class InterInst;
+class Var;
+
+/*
+	Control flow graph simplification on the code order.
+	A jump to an empty block holding only a jump goes straight to its
+	target, a jump to a return becomes the return, and a conditional jump
+	to a test decided by its own outcome goes on to the target of that
+	test. The test right after a conditional jump is decided the same way
+	when nothing else reaches it. Jumps to the next instruction go, a
+	conditional jump over a jump is inverted, code after a jump up to the
+	next label in use is unreachable and unused labels are dropped. A
+	block reached by one jump only and not by falling into it moves in
+	place of that jump when it ends with a jump itself.
+*/
+class CfgSimplify
+{
+	Fun*fun;
+	int rounds;//rounds over the code
+	int threaded;//jumps retargeted or turned into returns
+	int decided;//tests decided by an earlier one
+	int dropped;//jumps to the next instruction removed or inverted
+	int merged;//blocks moved to the jump reaching them
+	int removed;//unreachable instructions and unused labels removed
+	unordered_map<InterInst*,int>pos;//label -> index
+	unordered_map<InterInst*,int>refs;//label -> jumps to it
+
+	void index();//label positions and uses
+	int skip(int i);//first instruction from i that does something
+	InterInst* final(InterInst*lb);//end of the chain of jumps from lb
+	static int implied(InterInst*a,bool taken,InterInst*b);//outcome of b after a
+	void redirect(InterInst*inst,Operator op,InterInst*to,Var*arg1,Var*arg2);//retarget keeping refs
+	bool thread();//retarget jumps
+	bool drop();//remove jumps to the next instruction
+	bool unreachable();//remove code after jumps and unused labels
+	bool merge();//move blocks to the only jump reaching them
+public:
+	CfgSimplify(Fun*fun);
+
+	void simplify();//执行控制流图化简
+};
@@ -78,6 +78,9 @@ enum Operator
 	//算数运算
 	OP_ADD,OP_SUB,OP_MUL,OP_DIV,OP_MOD,//加减乘除模 eg: ADD result,arg1,arg2 => result=arg1 + arg2
 	OP_NEG,//负 eg: NEG result,arg1 => result = -arg1
+	//移位和位运算
+	OP_SHL,OP_SAR,OP_SHR,//左移 算术右移 逻辑右移 eg: SHL result,arg1,arg2 => result=arg1 << arg2
+	OP_BAND,OP_BOR,OP_BXOR,//按位与或异或 eg: BAND result,arg1,arg2 => result=arg1 & arg2
 	//比较运算
 	OP_GT,OP_GE,OP_LT,OP_LE,OP_EQU,OP_NE,//大小等 eg: GT result,arg1,arg2 => result=arg1 > arg2
 	//逻辑运算
@@ -94,7 +97,8 @@ enum Operator
 	OP_JMP,//无条件跳转 eg: JMP result => goto result
 	OP_JT,//真跳转	 eg: JT result,arg1 => if(arg1) goto result
 	OP_JF,//假跳转	 eg: JF result,arg1 => if(!arg1) goto result
-	/*OP_JG,OP_JGE,OP_JL,OP_JLE,OP_JE,*/OP_JNE,//跳转 eg:JG result,arg1,arg2 => if(arg1 > arg2) goto result
+	OP_JG,OP_JGE,OP_JL,OP_JLE,OP_JE,OP_JNE,//跳转 eg:JG result,arg1,arg2 => if(arg1 > arg2) goto result
+	OP_JTAB,//跳转表 eg:JTAB result,arg1,arg2 => goto table[arg1-arg2], result when out of the table
 	//函数调用
 	OP_ARG,//参数传递 eg: ARG arg1 => 传递参数arg1
 	OP_PROC,//调用过程 eg: PROC fun => 调用fun函数,fun()
@@ -180,6 +184,7 @@ enum SemError
 	EXPR_IS_VOID,				//表达式不能是VOID类型
 	BREAK_ERR,					//break不在循环或switch-case中
 	CONTINUE_ERR,				//continue不在循环中
+	CASE_RE_DEF,				//case值重复
 	RETURN_ERR					//return语句和函数返回值类型不匹配
 };
 
@@ -192,6 +197,8 @@ enum SemWarn
 	FUN_RET_CONFLICT		//函数返回值类型冲突
 };
 
+#define INLINE
+#define TAIL
 #define CONST
 #define RED
 #define DEAD
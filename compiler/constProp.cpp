@@ -0,0 +1,407 @@
+#include "constProp.h"
+#include "dfg.h"
+#include "dataFlow.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <algorithm>
+#include <limits.h>
+
+/*
+	Lattice value is a constant
+*/
+static bool isConst(double v)
+{
+	return v!=UNDEF&&v!=NAC;
+}
+
+/*
+	Meet of two lattice values
+*/
+static double meet(double a,double b)
+{
+	if(a==UNDEF)return b;
+	if(b==UNDEF)return a;
+	if(a==NAC||b==NAC||a!=b)return NAC;
+	return a;
+}
+
+/*
+	Worklist order: lower reverse post order first
+*/
+static bool later(Block*a,Block*b)
+{
+	return a->rpo>b->rpo;
+}
+
+ConstPropagation::ConstPropagation(Fun*fun,SymTab*tab)
+	:fun(fun),tab(tab),dfg(NULL),vars(NULL),folded(0),operands(0),branches(0),removed(0)
+{
+}
+
+ConstPropagation::~ConstPropagation()
+{
+	delete vars;
+	delete dfg;
+}
+
+/*
+	Scalars that are not memory variables are tracked. A variable with a
+	single definition that dominates all its uses has one value for the
+	whole function, other defined scalars get a slot in the block states.
+	Variables never defined here (parameters, uninitialised locals) are NAC.
+*/
+void ConstPropagation::classify()
+{
+	vector<InterInst*>&code=fun->getCode();
+	vars=new VarIndex(code);
+	int n=vars->size();
+	vector<int>defs(n,0);//number of definitions
+	vector<int>defPos(n,-1);//position of the last definition
+	for(int i=0;i<code.size();i++){
+		Var*def=code[i]->getDef();
+		if(!VarIndex::tracked(def))continue;
+		defs[def->index]++;
+		defPos[def->index]=i;
+	}
+	//a single definition must dominate every use
+	vector<char>single(n,0);
+	for(int i=0;i<n;i++){
+		Var*var=vars->get(i);
+		single[i]=defs[i]==1&&!vars->isMem(var)&&var->isBase()
+			&&code[defPos[i]]->block->reachable();
+	}
+	users.resize(n);
+	for(int i=0;i<code.size();i++){
+		Var*uses[2];
+		int m=code[i]->getUses(uses);
+		Block*b=code[i]->block;
+		for(int j=0;j<m;j++){
+			if(!VarIndex::tracked(uses[j]))continue;
+			int k=uses[j]->index;
+			if(!single[k]||!b->reachable())continue;
+			Block*d=code[defPos[k]]->block;
+			if(d==b?defPos[k]>=i:!dfg->dominates(d,b))single[k]=0;
+			else if(users[k].empty()||users[k].back()!=b)users[k].push_back(b);
+		}
+	}
+	slot.assign(n,-1);
+	vals.assign(n,NAC);
+	int slots=0;
+	for(int i=0;i<n;i++){
+		Var*var=vars->get(i);
+		if(!defs[i]||vars->isMem(var)||!var->isBase())continue;
+		if(single[i])vals[i]=UNDEF;
+		else slot[i]=slots++;
+	}
+	int blocks=dfg->getBlocks().size();
+	ins.assign(blocks,vector<double>(slots,UNDEF));
+	executable.assign(blocks,0);
+	queued.assign(blocks,0);
+}
+
+/*
+	Add to the worklist
+*/
+void ConstPropagation::push(Block*b)
+{
+	if(queued[b->id])return;
+	queued[b->id]=1;
+	heap.push_back(b);
+	push_heap(heap.begin(),heap.end(),later);
+}
+
+/*
+	First block of the worklist in reverse post order, NULL when empty
+*/
+Block*ConstPropagation::pop()
+{
+	if(heap.empty())return NULL;
+	pop_heap(heap.begin(),heap.end(),later);
+	Block*b=heap.back();
+	heap.pop_back();
+	queued[b->id]=0;
+	return b;
+}
+
+/*
+	Iterate to the fixed point, starting from the entry
+*/
+void ConstPropagation::run()
+{
+	Block*entry=dfg->getEntry();
+	executable[entry->id]=1;
+	ins[entry->id].assign(ins[entry->id].size(),NAC);
+	push(entry);
+	while(Block*b=pop())visit(b);
+}
+
+/*
+	Evaluate a block and propagate its state along the edges that can be taken
+*/
+void ConstPropagation::visit(Block*b)
+{
+	vector<double>state=ins[b->id];
+	for(int i=0;i<b->insts.size();i++)
+		transfer(b->insts[i],state);
+	InterInst*last=b->insts.back();
+	if(last->getOp()==OP_JTAB){//a known index takes one label
+		double v=value(last->getArg1(),state);
+		if(isConst(v))flowTo(last->caseOf((int)v)->block,state);
+		else if(v==NAC)
+			for(int i=0;i<b->succs.size();i++)flowTo(b->succs[i],state);
+		return;
+	}
+	if(!last->isJcond()){
+		for(int i=0;i<b->succs.size();i++)flowTo(b->succs[i],state);
+		return;
+	}
+	int taken=branch(last,state);
+	Block*target=last->getTarget()->block;
+	Block*next=dfg->getBlocks()[b->id+1];
+	if(taken==1||taken==-1)flowTo(target,state);
+	if(taken==0||taken==-1)flowTo(next,state);
+}
+
+/*
+	Merge state into the start of b, queue b if it changed
+*/
+void ConstPropagation::flowTo(Block*b,vector<double>&state)
+{
+	vector<double>&in=ins[b->id];
+	if(!executable[b->id]){
+		executable[b->id]=1;
+		in=state;
+		push(b);
+		return;
+	}
+	bool changed=false;
+	for(int i=0;i<in.size();i++){
+		double v=meet(in[i],state[i]);
+		if(v!=in[i]){
+			in[i]=v;
+			changed=true;
+		}
+	}
+	if(changed)push(b);
+}
+
+/*
+	Lattice value of an operand
+*/
+double ConstPropagation::value(Var*var,vector<double>&state)
+{
+	if(!var)return NAC;
+	if(var->isLiteral())return var->isChar()?(unsigned char)var->getVal():var->getVal();
+	if(!VarIndex::tracked(var))return NAC;
+	int i=var->index;
+	return slot[i]>=0?state[slot[i]]:vals[i];
+}
+
+/*
+	Record a definition. A single valued variable that drops in the lattice
+	wakes up the executable blocks using it.
+*/
+void ConstPropagation::define(Var*var,double val,vector<double>&state)
+{
+	int i=var->index;
+	if(slot[i]>=0){
+		state[slot[i]]=val;
+		return;
+	}
+	double v=meet(vals[i],val);
+	if(v==vals[i])return;
+	vals[i]=v;
+	for(int j=0;j<users[i].size();j++)
+		if(executable[users[i][j]->id])push(users[i][j]);
+}
+
+/*
+	Evaluate an instruction, returns the value it defines
+*/
+double ConstPropagation::transfer(InterInst*inst,vector<double>&state)
+{
+	Var*def=inst->getDef();
+	if(!VarIndex::tracked(def))return NAC;
+	Operator op=inst->getOp();
+	double v=NAC;
+	if(op==OP_DEC)v=def->isBase()?def->getVal():NAC;
+	else if(op==OP_AS)v=value(inst->getArg1(),state);
+	else if(op>=OP_ADD&&op<=OP_OR)
+		v=fold(op,value(inst->getArg1(),state),value(inst->getArg2(),state));
+	else if(op==OP_CALL){//a callee returning the same literal everywhere
+		int ret;
+		if(inst->getFun()->constReturn(ret))v=ret;
+	}
+	if(!def->isBase())v=NAC;
+	else if(def->isChar()&&isConst(v))v=(unsigned char)(int)v;//stored in a byte, loaded zero extended
+	define(def,v,state);
+	return v;
+}
+
+/*
+	Outcome of a conditional branch: 1 taken, 0 not taken, -1 unknown and
+	-2 while the condition is still undefined
+*/
+int ConstPropagation::branch(InterInst*inst,vector<double>&state)
+{
+	double a=value(inst->getArg1(),state);
+	double b=inst->getArg2()?value(inst->getArg2(),state):0;
+	if(a==UNDEF||b==UNDEF)return -2;
+	if(a==NAC||b==NAC)return -1;
+	switch(inst->getOp()){
+		case OP_JT:return a!=0;
+		case OP_JF:return a==0;
+		case OP_JG:return a>b;
+		case OP_JGE:return a>=b;
+		case OP_JL:return a<b;
+		case OP_JLE:return a<=b;
+		case OP_JE:return a==b;
+		default:return a!=b;
+	}
+}
+
+/*
+	Compute an operator on lattice values, b is ignored for unary operators.
+	Division by zero and overflowing division are left to run time.
+*/
+double ConstPropagation::fold(Operator op,double a,double b)
+{
+	if((op==OP_MUL||op==OP_AND||op==OP_BAND)&&(a==0||b==0))return 0;
+	if(op==OP_OR&&(isConst(a)&&a!=0||isConst(b)&&b!=0))return 1;
+	bool unary=op==OP_NEG||op==OP_NOT;
+	if(a==NAC||!unary&&b==NAC)return NAC;
+	if(a==UNDEF||!unary&&b==UNDEF)return UNDEF;
+	int x=(int)a,y=unary?0:(int)b;
+	switch(op){
+		case OP_ADD:return (int)((unsigned)x+(unsigned)y);
+		case OP_SUB:return (int)((unsigned)x-(unsigned)y);
+		case OP_MUL:return (int)((unsigned)x*(unsigned)y);
+		case OP_DIV:
+			if(y==0||x==INT_MIN&&y==-1)return NAC;
+			return x/y;
+		case OP_MOD:
+			if(y==0||x==INT_MIN&&y==-1)return NAC;
+			return x%y;
+		case OP_NEG:return (int)(0u-(unsigned)x);
+		case OP_SHL:return (int)((unsigned)x<<(y&31));
+		case OP_SAR:return x>>(y&31);
+		case OP_SHR:return (int)((unsigned)x>>(y&31));
+		case OP_BAND:return x&y;
+		case OP_BOR:return x|y;
+		case OP_BXOR:return x^y;
+		case OP_GT:return x>y;
+		case OP_GE:return x>=y;
+		case OP_LT:return x<y;
+		case OP_LE:return x<=y;
+		case OP_EQU:return x==y;
+		case OP_NE:return x!=y;
+		case OP_NOT:return !x;
+		case OP_AND:return x&&y;
+		case OP_OR:return x||y;
+		default:return NAC;
+	}
+}
+
+/*
+	Literal variable of a value, one per value and function
+*/
+Var*ConstPropagation::literal(int val)
+{
+	map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	Replay the executable blocks with their final states: constant results
+	become literal copies, constant operands become literals and branches
+	with a known outcome become jumps or are dropped. Unexecutable blocks
+	are deleted except for declarations and the exit.
+*/
+void ConstPropagation::rewrite()
+{
+	vector<Block*>&blocks=dfg->getBlocks();
+	for(int i=0;i<blocks.size();i++){
+		Block*b=blocks[i];
+		if(!executable[b->id]){
+			if(b==dfg->getExit())continue;
+			for(int j=0;j<b->insts.size();j++){
+				InterInst*inst=b->insts[j];
+				if(inst->isLb()||inst->getOp()!=OP_DEC){
+					inst->isDead=true;
+					removed++;
+				}
+			}
+			continue;
+		}
+		vector<double>state=ins[b->id];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb())continue;
+			Operator op=inst->getOp();
+			if(op==OP_JTAB){
+				double v=value(inst->getArg1(),state);
+				if(isConst(v)){
+					inst->replace(OP_JMP,inst->caseOf((int)v));
+					branches++;
+				}
+				continue;
+			}
+			if(inst->isJcond()){
+				int taken=branch(inst,state);
+				if(taken==1)inst->replace(OP_JMP,inst->getTarget());
+				else if(taken==0)inst->isDead=true;
+				if(taken>=0){
+					branches++;
+					continue;
+				}
+			}
+			//operands read as values can become literals, SET stores its result field
+			Var*args[3]={inst->getResult(),inst->getArg1(),inst->getArg2()};
+			int first=1,last=2;
+			if(op==OP_SET)first=last=0;
+			else if(!(op==OP_AS||op>=OP_ADD&&op<=OP_OR||op==OP_ARG||op==OP_RETV||inst->isJcond()))last=0;
+			int replaced=0;
+			for(int k=first;k<=last;k++){
+				double v=value(args[k],state);
+				if(isConst(v)&&!args[k]->isLiteral()){
+					args[k]=literal((int)v);
+					replaced++;
+				}
+			}
+			double v=transfer(inst,state);
+			Var*def=inst->getDef();
+			if((op==OP_AS||op>=OP_ADD&&op<=OP_OR)&&isConst(v)){
+				if(op!=OP_AS||!inst->getArg1()->isLiteral()){
+					inst->replace(OP_AS,def,literal((int)v));
+					folded++;
+				}
+				continue;
+			}
+			if(!replaced)continue;
+			operands+=replaced;
+			if(op==OP_RETV||inst->isJcond())inst->replace(op,inst->getTarget(),args[1],args[2]);
+			else inst->replace(op,args[0],args[1],args[2]);
+		}
+	}
+	fun->getInterCode().removeDead();
+}
+
+/*
+	执行常量传播
+*/
+void ConstPropagation::propagate()
+{
+	dfg=new DFG(fun->getInterCode());
+	classify();
+	run();
+	rewrite();
+	if(Args::stats)
+		fprintf(stderr,"%s: constant propagation folded %d, operands %d, branches %d, unreachable %d\n",
+			fun->getName().c_str(),folded,operands,branches,removed);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include "common.h"
+
+class Var;
+class Fun;
+class SymTab;
+class InterInst;
+class Block;
+class DFG;
+class VarIndex;
+
+#define UNDEF 0.5//未定义，还没有确定的值
+#define NAC -0.5//不是常量
+
+/*
+	Sparse conditional constant propagation.
+	Blocks become executable only through edges whose branch can be taken,
+	values only flow along those edges. Variables with one definition that
+	dominates all their uses keep a single value, other scalars are tracked
+	per block; memory variables and pointers are never constant. A call
+	to a function whose every return gives the same literal defines it.
+	Afterwards constant results are folded into copies of literals, known
+	branches become jumps or disappear and unexecutable blocks are deleted.
+*/
+class ConstPropagation
+{
+	Fun*fun;
+	SymTab*tab;
+	DFG*dfg;
+	VarIndex*vars;
+
+	vector<int>slot;//per block state slot of every variable, -1 if none
+	vector<double>vals;//value of every variable that has no slot
+	vector<vector<double> >ins;//state at the start of every block
+	vector<char>executable;//block can be executed
+	vector<vector<Block*> >users;//blocks using every single valued variable
+	vector<char>queued;//block is in the worklist
+	vector<Block*>heap;//worklist, ordered by reverse post order
+	map<int,Var*>literals;//literals created for folded values
+
+	int folded;//instructions turned into literal copies
+	int operands;//operands replaced by literals
+	int branches;//conditional branches resolved
+	int removed;//unreachable instructions deleted
+
+	void classify();//single valued variables and state slots
+	void push(Block*b);//add to the worklist
+	Block*pop();//first block of the worklist in reverse post order
+	void run();//iterate to the fixed point
+	void visit(Block*b);//evaluate a block and propagate to its successors
+	void flowTo(Block*b,vector<double>&state);//merge state into the start of b
+	double value(Var*var,vector<double>&state);//lattice value of an operand
+	void define(Var*var,double val,vector<double>&state);//record a definition
+	double transfer(InterInst*inst,vector<double>&state);//evaluate an instruction, returns the value it defines
+	int branch(InterInst*inst,vector<double>&state);//1 taken, 0 not taken, -1 unknown, -2 undefined
+	Var*literal(int val);//literal variable of a value
+	void rewrite();//fold, resolve branches and delete unreachable code
+public:
+	ConstPropagation(Fun*fun,SymTab*tab);
+	~ConstPropagation();
+
+	void propagate();//执行常量传播
+	static double fold(Operator op,double a,double b);//compute an operator on lattice values
+};
@@ -0,0 +1,177 @@
+#include "copyProp.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+#include "args.h"
+
+/*
+	Number the copies, then compute gen and kill of every block and solve
+*/
+CopyPropagation::CopyPropagation(Fun*fun)
+	:DataFlow(new DFG(fun->getInterCode()),FORWARD,INTERSECT),
+	fun(fun),vars(fun->getCode()),alias(vars,fun->getCode()),replaced(0)
+{
+	vector<InterInst*>&code=fun->getCode();
+	srcCopies.resize(vars.size());
+	dstCopies.resize(vars.size());
+	killedIn.assign(vars.size(),-1);
+	cur.assign(vars.size(),-1);
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(!isCopy(inst))continue;
+		Copy c={inst->getResult(),inst->getArg1()};
+		int id=copies.size();
+		instCopy[inst]=id;
+		copies.push_back(c);
+		srcCopies[c.src->index].push_back(id);
+		dstCopies[c.dst->index].push_back(id);
+	}
+	memCopies.init(copies.size(),false);
+	for(int i=0;i<copies.size();i++)
+		if(alias.isEscaped(copies[i].dst)||alias.isEscaped(copies[i].src))memCopies.set(i);
+	if(!init(copies.size()))return;
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int j=0;j<b->insts.size();j++){
+			addKills(b->insts[j],b);
+			step(b->insts[j],gen[b->id]);
+		}
+	}
+	solve(Set(copies.size()));
+}
+
+CopyPropagation::~CopyPropagation()
+{
+	delete dfg;
+}
+
+/*
+	Copy between variables of the same kind. Arrays are addresses rather
+	than values, char and int differ in what is stored.
+*/
+bool CopyPropagation::isCopy(InterInst*inst)
+{
+	if(inst->isLb()||inst->getOp()!=OP_AS)return false;
+	Var*dst=inst->getResult();
+	Var*src=inst->getArg1();
+	if(!VarIndex::tracked(dst)||!VarIndex::tracked(src)||dst==src)return false;
+	if(dst->getArray()||src->getArray())return false;
+	return dst->isChar()==src->isChar()&&dst->isBase()==src->isBase();
+}
+
+/*
+	Copies killed by inst into the kill set of b: those reading or writing
+	the variable it defines, a call writes or a store may write through a
+	known pointer, and those of escaped variables for calls with unknown
+	effects and stores through wild pointers
+*/
+void CopyPropagation::addKills(InterInst*inst,Block*b)
+{
+	killCopies(inst->getDef(),b);
+	vector<Var*>&writes=inst->getWrites();//globals written by the callee
+	for(int k=0;k<writes.size();k++)killCopies(writes[k],b);
+	if(!inst->isLb()&&inst->getOp()==OP_SET){
+		Set&to=alias.getTargets(inst->getArg1());
+		for(int o=to.next(0);o!=-1;o=to.next(o+1))killCopies(alias.getObj(o),b);
+		if(alias.isWild(inst->getArg1()))kill[b->id].unite(memCopies);
+	}
+	else if(inst->unknown())kill[b->id].unite(memCopies);
+}
+
+/*
+	Add the copies reading or writing var to the kill set of b, once per
+	block
+*/
+void CopyPropagation::killCopies(Var*var,Block*b)
+{
+	if(!vars.has(var)||killedIn[var->index]==b->id)return;
+	killedIn[var->index]=b->id;
+	Set&killed=kill[b->id];
+	vector<int>&src=srcCopies[var->index];
+	for(int i=0;i<src.size();i++)killed.set(src[i]);
+	vector<int>&dst=dstCopies[var->index];
+	for(int i=0;i<dst.size();i++)killed.set(dst[i]);
+}
+
+/*
+	Start a walk with the copies available. At most one copy into a
+	variable is available, cur remembers which.
+*/
+void CopyPropagation::enter(Set&avail)
+{
+	for(int i=avail.next(0);i!=-1;i=avail.next(i+1))
+		cur[copies[i].dst->index]=i;
+}
+
+/*
+	Available before inst -> available after inst
+*/
+void CopyPropagation::step(InterInst*inst,Set&avail)
+{
+	vector<Var*>&writes=inst->getWrites();
+	for(int k=0;k<writes.size();k++)drop(writes[k],avail);
+	if(!inst->isLb()&&inst->getOp()==OP_SET){
+		Set&to=alias.getTargets(inst->getArg1());
+		for(int o=to.next(0);o!=-1;o=to.next(o+1))drop(alias.getObj(o),avail);
+		if(alias.isWild(inst->getArg1()))avail.subtract(memCopies);
+	}
+	else if(inst->unknown())avail.subtract(memCopies);
+	Var*def=inst->getDef();
+	drop(def,avail);
+	unordered_map<InterInst*,int>::iterator it=instCopy.find(inst);
+	if(it!=instCopy.end()){
+		avail.set(it->second);
+		cur[def->index]=it->second;
+	}
+}
+
+/*
+	The copies reading or writing var are no longer available
+*/
+void CopyPropagation::drop(Var*var,Set&avail)
+{
+	if(!vars.has(var))return;
+	int c=cur[var->index];
+	if(c>=0)avail.reset(c);
+	vector<int>&src=srcCopies[var->index];
+	for(int i=0;i<src.size();i++)avail.reset(src[i]);
+}
+
+/*
+	Variable var is an available copy of, NULL if none
+*/
+Var*CopyPropagation::source(Var*var,Set&avail)
+{
+	if(!VarIndex::tracked(var))return NULL;
+	int c=cur[var->index];
+	return c>=0&&avail.get(c)?copies[c].src:NULL;
+}
+
+/*
+	执行复写传播: walk every block with its available copies and let the
+	uses read the sources. The source recorded for the copy is used, not
+	a source rewritten meanwhile, since only the former is known to hold.
+*/
+void CopyPropagation::propagate()
+{
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		Set avail=getIn(b);
+		enter(avail);
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			Var*uses[2];
+			int n=inst->getUses(uses);
+			for(int k=0;k<n;k++){
+				Var*src=source(uses[k],avail);
+				if(src)replaced+=inst->replaceUse(uses[k],src);
+			}
+			step(inst,avail);
+		}
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: copy propagation %d copies, %d operands replaced\n",
+			fun->getName().c_str(),(int)copies.size(),replaced);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "dataFlow.h"
+#include "pointsTo.h"
+#include <unordered_map>
+
+class Fun;
+
+/*
+	Global copy propagation.
+	Available copies is a forward intersection problem over the copies
+	x=y between variables of the same kind: defining x or y kills the
+	copy, a store kills the copies of the variables its pointer may point
+	to, a store through a wild pointer or a call those of every escaped
+	variable (see PointsTo). Uses of x
+	where x=y is available read y instead, the copy is then left to dead
+	code elimination.
+*/
+class CopyPropagation:public DataFlow
+{
+	//a copy dst=src
+	struct Copy
+	{
+		Var*dst;
+		Var*src;
+	};
+
+	Fun*fun;
+	VarIndex vars;
+	PointsTo alias;//targets of the stores
+	vector<Copy>copies;//copies by index
+	unordered_map<InterInst*,int>instCopy;//copy made by an instruction
+	vector<vector<int> >srcCopies;//copies reading every variable
+	vector<vector<int> >dstCopies;//copies writing every variable
+	vector<int>killedIn;//last block whose kill set has the copies of every variable
+	vector<int>cur;//copy last made into every variable, valid while available
+	Set memCopies;//copies reading or writing escaped variables
+	int replaced;//operands rewritten
+
+	static bool isCopy(InterInst*inst);//copy between variables of the same kind
+	void addKills(InterInst*inst,Block*b);//copies killed by inst into the kill set of b
+	void killCopies(Var*var,Block*b);//copies of var into the kill set of b
+	void drop(Var*var,Set&avail);//copies of var no longer available
+	void enter(Set&avail);//start a walk with the copies available
+	void step(InterInst*inst,Set&avail);//available before inst -> available after inst
+	Var*source(Var*var,Set&avail);//variable var is an available copy of, NULL if none
+public:
+	CopyPropagation(Fun*fun);
+	~CopyPropagation();
+
+	void propagate();//执行复写传播
+};
@@ -0,0 +1,253 @@
+#include "dataFlow.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+#include <algorithm>
+
+/*******************************************************************************
+                                   数据流求解器
+*******************************************************************************/
+
+static const long long budget=1LL<<28;//bits of one set per block, 32MB
+
+DataFlow::DataFlow(DFG*dfg,Dir dir,Meet meet)
+	:dfg(dfg),dir(dir),meet(meet),width(0),sweeps(0),visits(0),local(false)
+{
+}
+
+/*
+	Allocate the block sets, false if over the budget. Reachable blocks
+	start at the identity of the meet, unreachable blocks keep empty sets
+	and never take part. Over the budget there is one conservative set
+	standing for every block boundary.
+*/
+bool DataFlow::init(int width)
+{
+	this->width=width;
+	int n=dfg->getBlocks().size();
+	if((long long)n*width>budget){
+		local=true;
+		in.assign(1,Set(width,meet==UNION));
+		out.assign(1,in[0]);
+		return false;
+	}
+	gen.assign(n,Set(width));
+	kill.assign(n,Set(width));
+	in.assign(n,Set(width));
+	out.assign(n,Set(width));
+	if(meet==INTERSECT){
+		vector<Block*>&order=dfg->getOrder();
+		for(int i=0;i<order.size();i++){
+			in[order[i]->id].fill(true);
+			out[order[i]->id].fill(true);
+		}
+	}
+	return true;
+}
+
+/*
+	Iterate to the fixed point. The boundary is the in set of the entry for
+	forward problems and the out set of the exit for backward ones.
+*/
+void DataFlow::solve(const Set&boundary)
+{
+	vector<Block*>order=dfg->getOrder();
+	if(dir==BACKWARD)reverse(order.begin(),order.end());
+	Block*edge=dir==FORWARD?dfg->getEntry():dfg->getExit();
+	vector<char>dirty(dfg->getBlocks().size(),1);
+	int pending=order.size();
+	while(pending){
+		sweeps++;
+		for(int i=0;i<order.size();i++){
+			Block*b=order[i];
+			if(!dirty[b->id])continue;
+			dirty[b->id]=0;
+			pending--;
+			visits++;
+			//meet over the neighbours the facts come from
+			Set&x=dir==FORWARD?in[b->id]:out[b->id];
+			vector<Block*>&from=dir==FORWARD?b->prevs:b->succs;
+			if(b==edge)x=boundary;
+			else{
+				bool first=true;
+				for(int j=0;j<from.size();j++){
+					Block*p=from[j];
+					if(!p->reachable())continue;
+					Set&y=dir==FORWARD?out[p->id]:in[p->id];
+					if(first)x=y;
+					else if(meet==UNION)x.unite(y);
+					else x.intersect(y);
+					first=false;
+				}
+			}
+			//transfer, wake up the neighbours the facts go to
+			Set&y=dir==FORWARD?out[b->id]:in[b->id];
+			if(!y.transfer(gen[b->id],x,kill[b->id]))continue;
+			vector<Block*>&to=dir==FORWARD?b->succs:b->prevs;
+			for(int j=0;j<to.size();j++){
+				Block*s=to[j];
+				if(s->reachable()&&!dirty[s->id]){
+					dirty[s->id]=1;
+					pending++;
+				}
+			}
+		}
+	}
+}
+
+/*
+	Facts at the start of the block
+*/
+Set&DataFlow::getIn(Block*b)
+{
+	return local?in[0]:in[b->id];
+}
+
+/*
+	Facts at the end of the block
+*/
+Set&DataFlow::getOut(Block*b)
+{
+	return local?out[0]:out[b->id];
+}
+
+/*
+	Number of facts
+*/
+int DataFlow::getWidth()
+{
+	return width;
+}
+
+/*
+	Passes over the block order
+*/
+int DataFlow::getSweeps()
+{
+	return sweeps;
+}
+
+/*
+	Block transfers evaluated
+*/
+int DataFlow::getVisits()
+{
+	return visits;
+}
+
+/*
+	Over the budget, not solved
+*/
+bool DataFlow::isLocal()
+{
+	return local;
+}
+
+/*******************************************************************************
+                                   变量编号
+*******************************************************************************/
+
+/*
+	Number every variable declared, defined or used by the code
+*/
+VarIndex::VarIndex(vector<InterInst*>&code)
+{
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())continue;
+		if(inst->getOp()==OP_DEC)add(inst->getArg1());
+		add(inst->getDef());
+		Var*uses[2];
+		int n=inst->getUses(uses);
+		for(int j=0;j<n;j++)add(uses[j]);
+	}
+	mem.init(vars.size(),false);
+	globals.init(vars.size(),false);
+	for(int i=0;i<vars.size();i++){
+		Var*var=vars[i];
+		bool global=var->getPath().size()==1;
+		if(global)globals.set(i);
+		if(global||var->getArray()||var->inMem)mem.set(i);
+	}
+}
+
+/*
+	Variable that can be numbered: not a literal nor void
+*/
+bool VarIndex::tracked(Var*var)
+{
+	return var&&var->notConst()&&!var->isVoid();
+}
+
+/*
+	Number a variable once
+*/
+void VarIndex::add(Var*var)
+{
+	if(!tracked(var))return;
+	if(var->index>=0&&var->index<vars.size()&&vars[var->index]==var)return;
+	var->index=vars.size();
+	vars.push_back(var);
+}
+
+/*
+	Number of variables
+*/
+int VarIndex::size()
+{
+	return vars.size();
+}
+
+/*
+	Variable with index i
+*/
+Var*VarIndex::get(int i)
+{
+	return vars[i];
+}
+
+/*
+	Memory variables
+*/
+Set&VarIndex::getMem()
+{
+	return mem;
+}
+
+/*
+	Global variables
+*/
+Set&VarIndex::getGlobals()
+{
+	return globals;
+}
+
+/*
+	Memory variable
+*/
+bool VarIndex::isMem(Var*var)
+{
+	return mem.get(var->index);
+}
+
+/*
+	Variable numbered by this index, a global may carry the index of
+	another function
+*/
+bool VarIndex::has(Var*var)
+{
+	return tracked(var)&&var->index>=0&&var->index<vars.size()&&vars[var->index]==var;
+}
+
+/*
+	Names of the variables in s
+*/
+string VarIndex::toString(const Set&s)
+{
+	string str;
+	for(int i=s.next(0);i!=-1;i=s.next(i+1)){
+		if(str!="")str+=" ";
+		str+=vars[i]->getName();
+	}
+	return str;
+}
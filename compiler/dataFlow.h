@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include "common.h"
+#include "set.h"
+
+class Var;
+class InterInst;
+class Block;
+class DFG;
+
+/*
+	Iterative dataflow solver over the blocks of a DFG.
+	A problem gives per block gen and kill sets, the solver computes
+	out=gen|(in&~kill) for forward problems and in=gen|(out&~kill) for
+	backward ones, meeting over the reachable neighbours by union or
+	intersection. Blocks are visited in reverse post order (reversed for
+	backward problems) and only when one of their inputs changed.
+	When blocks*facts exceeds the memory budget the problem is not solved:
+	every block boundary gets the conservative answer (all facts for union
+	problems, none for intersection ones) and clients work block locally.
+*/
+class DataFlow
+{
+public:
+	enum Dir{FORWARD,BACKWARD};//direction of propagation
+	enum Meet{UNION,INTERSECT};//meet operator
+protected:
+	DFG*dfg;
+	Dir dir;
+	Meet meet;
+	int width;//number of facts
+	vector<Set>gen,kill,in,out;//indexed by Block::id
+	int sweeps;//passes over the block order
+	int visits;//block transfers evaluated
+	bool local;//over the budget, block boundaries are conservative
+
+	bool init(int width);//allocate the block sets, false if over the budget
+	void solve(const Set&boundary);//iterate to the fixed point, boundary is the entry in or exit out
+public:
+	DataFlow(DFG*dfg,Dir dir,Meet meet);
+
+	Set&getIn(Block*b);//facts at the start of the block
+	Set&getOut(Block*b);//facts at the end of the block
+	int getWidth();//number of facts
+	int getSweeps();//passes over the block order
+	int getVisits();//block transfers evaluated
+	bool isLocal();//over the budget, not solved
+};
+
+/*
+	Numbering of the variables referenced by a function, sets Var::index.
+	Memory variables (globals, arrays and variables whose address is taken)
+	may also be read or written through pointers and by calls.
+*/
+class VarIndex
+{
+	vector<Var*>vars;//variables by index
+	Set mem;//memory variables
+	Set globals;//global variables
+
+	void add(Var*var);//number a variable once
+public:
+	VarIndex(vector<InterInst*>&code);
+
+	static bool tracked(Var*var);//variable that can be numbered: not a literal nor void
+	int size();//number of variables
+	Var*get(int i);//variable with index i
+	Set&getMem();//memory variables
+	Set&getGlobals();//global variables
+	bool isMem(Var*var);//memory variable
+	bool has(Var*var);//variable numbered here
+	string toString(const Set&s);//names of the variables in s
+};
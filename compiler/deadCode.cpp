@@ -0,0 +1,143 @@
+#include "deadCode.h"
+#include "liveVar.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+#include "args.h"
+#include <unordered_set>
+
+DeadCodeElim::DeadCodeElim(Fun*fun):fun(fun),rounds(0),dead(0),unreachable(0),calls(0),pure(0),decs(0)
+{
+}
+
+/*
+	No side effect besides its result: copies, arithmetic, comparisons,
+	loads and address computations
+*/
+bool DeadCodeElim::removable(InterInst*inst)
+{
+	Operator op=inst->getOp();
+	return !inst->isLb()&&(op>=OP_AS&&op<=OP_OR||op==OP_GET||op==OP_LEA);
+}
+
+/*
+	Drop the call at b->insts[j] to a pure function that terminates along
+	with its arguments, found backwards in the block before any other call
+*/
+bool DeadCodeElim::dropCall(Block*b,int j)
+{
+	InterInst*call=b->insts[j];
+	Fun*callee=call->getFun();
+	if(!callee->isPure()||!callee->terminates())return false;
+	vector<InterInst*>args;
+	int n=callee->getParaVar().size();
+	for(int k=j-1;k>=0&&args.size()<n;k--){
+		InterInst*inst=b->insts[k];
+		if(inst->isLb())continue;
+		Operator op=inst->getOp();
+		if(op==OP_CALL||op==OP_PROC)break;
+		if(op==OP_ARG&&!inst->isDead)args.push_back(inst);
+	}
+	if(args.size()<n)return false;
+	call->isDead=true;
+	for(int k=0;k<args.size();k++)args[k]->isDead=true;
+	dead+=n+1;
+	return true;
+}
+
+/*
+	One round: drop unreachable blocks, solve liveness and walk every block
+	backwards. A removed instruction does not make its operands live, so
+	chains inside a block go in one round.
+*/
+bool DeadCodeElim::sweep()
+{
+	InterCode&code=fun->getInterCode();
+	int n=0;
+	{
+		DFG dfg(code);
+		int lost=dfg.markUnreachable();
+		unreachable+=lost;
+		n+=lost;
+		LiveVar live(&dfg,code.getCode());
+		rounds++;
+		vector<Block*>&order=dfg.getOrder();
+		for(int i=0;i<order.size();i++){
+			Block*b=order[i];
+			Set out=live.getOut(b);
+			for(int j=b->insts.size()-1;j>=0;j--){
+				InterInst*inst=b->insts[j];
+				if(inst->isDead)continue;//argument of a pure call dropped
+				Var*def=inst->getDef();
+				bool unused=VarIndex::tracked(def)&&!out.get(def->index);
+				if(removable(inst)&&(unused||inst->getOp()==OP_AS&&inst->getArg1()==def)){
+					inst->isDead=true;
+					dead++;
+					n++;
+					continue;
+				}
+				Operator op=inst->getOp();
+				if((op==OP_PROC||op==OP_CALL&&unused)&&dropCall(b,j)){
+					pure++;
+					n++;
+					continue;
+				}
+				if(op==OP_CALL&&unused){
+					inst->callToProc();
+					calls++;
+				}
+				live.step(inst,out);
+			}
+		}
+	}
+	code.removeDead();
+	return n>0;
+}
+
+/*
+	Drop declarations of variables no other instruction references, an
+	initialised one only writes a value nobody reads. The frame layout
+	then gives them no space.
+*/
+void DeadCodeElim::removeDecs()
+{
+	vector<InterInst*>&code=fun->getCode();
+	unordered_set<Var*>used;
+	for(int i=0;i<code.size();i++){
+		if(code[i]->getOp()==OP_DEC&&!code[i]->isLb())continue;
+		Var*def=code[i]->getDef();
+		if(def)used.insert(def);
+		Var*uses[2];
+		int m=code[i]->getUses(uses);
+		for(int j=0;j<m;j++)used.insert(uses[j]);
+	}
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->getOp()!=OP_DEC)continue;
+		if(!used.count(inst->getArg1())){
+			inst->isDead=true;
+			decs++;
+		}
+	}
+	fun->getInterCode().removeDead();
+}
+
+/*
+	执行死代码消除
+*/
+void DeadCodeElim::eliminate()
+{
+	while(sweep());
+	removeDecs();
+	if(Args::stats)
+		fprintf(stderr,"%s: dead code removed %d dead, %d unreachable, %d unused declarations, %d call results, %d pure calls in %d rounds\n",
+			fun->getName().c_str(),dead,unreachable,decs,calls,pure,rounds);
+}
+
+/*
+	Instructions removed
+*/
+int DeadCodeElim::getRemoved()
+{
+	return dead+unreachable+decs;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "common.h"
+
+class Fun;
+class InterInst;
+class Block;
+
+/*
+	Dead code elimination driven by live variables.
+	An instruction without side effects whose result is not live is
+	removed, a call whose result is not live keeps only the call. A call
+	to a pure function whose result is not live goes with its arguments.
+	Rounds alternate with unreachable block removal until nothing changes,
+	then declarations of variables that lost all references go too.
+*/
+class DeadCodeElim
+{
+	Fun*fun;
+	int rounds;//liveness solves
+	int dead;//instructions removed as dead
+	int unreachable;//instructions removed as unreachable
+	int calls;//calls whose result was dropped
+	int pure;//calls to pure functions removed
+	int decs;//declarations of unreferenced variables removed
+
+	static bool removable(InterInst*inst);//no side effect besides its result
+	bool dropCall(Block*b,int j);//remove a pure call and its arguments
+	bool sweep();//one round, true if something changed
+	void removeDecs();//drop declarations of unreferenced variables
+public:
+	DeadCodeElim(Fun*fun);
+
+	void eliminate();//执行死代码消除
+	int getRemoved();//instructions removed
+};
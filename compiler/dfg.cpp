@@ -0,0 +1,391 @@
+#include "dfg.h"
+#include "interCode.h"
+#include <algorithm>
+
+/*******************************************************************************
+                                   基本块
+*******************************************************************************/
+
+Block::Block(int id):id(id)
+{
+	rpo=-1;
+	idom=NULL;
+	domPre=domPost=-1;
+	loop=NULL;
+	loopDepth=0;
+}
+
+/*
+	Reached from the entry
+*/
+bool Block::reachable()
+{
+	return rpo>=0;
+}
+
+/*
+	Print the block
+*/
+void Block::toString()
+{
+	printf("B%d:",id);
+	if(!reachable())printf(" unreachable");
+	else{
+		printf(" rpo=%d",rpo);
+		if(idom)printf(" idom=B%d",idom->id);
+		if(loopDepth)printf(" loop=B%d depth=%d",loop->header->id,loopDepth);
+	}
+	printf("\n\tprev:");
+	for(int i=0;i<prevs.size();i++)printf(" B%d",prevs[i]->id);
+	printf("\n\tsucc:");
+	for(int i=0;i<succs.size();i++)printf(" B%d",succs[i]->id);
+	printf("\n");
+	for(int i=0;i<insts.size();i++){
+		printf("\t");
+		insts[i]->toString();
+	}
+}
+
+/*******************************************************************************
+                                   循环
+*******************************************************************************/
+
+Loop::Loop(Block* header):header(header)
+{
+	parent=NULL;
+	depth=1;
+}
+
+/*
+	Block is in the body
+*/
+bool Loop::contains(Block* b)
+{
+	for(Loop* l=b->loop;l;l=l->parent)
+		if(l==this)return true;
+	return false;
+}
+
+/*
+	Loop is nested in this one or is this one
+*/
+bool Loop::contains(Loop* l)
+{
+	for(;l;l=l->parent)
+		if(l==this)return true;
+	return false;
+}
+
+/*******************************************************************************
+                                   流图
+*******************************************************************************/
+
+DFG::DFG(InterCode& code)
+{
+	code.markFirst();
+	createBlocks(code.getCode());
+	linkBlocks();
+	computeOrder();
+	computeDom();
+	numberDomTree();
+	findLoops();
+}
+
+DFG::~DFG()
+{
+	for(int i=0;i<blocks.size();i++)
+		delete blocks[i];
+	for(int i=0;i<loops.size();i++)
+		delete loops[i];
+}
+
+/*
+	Split code at leaders marked by InterCode::markFirst
+*/
+void DFG::createBlocks(vector<InterInst*>& code)
+{
+	Block* cur=NULL;
+	for(int i=0;i<code.size();i++){
+		InterInst* inst=code[i];
+		if(inst->isFirst()||!cur){
+			cur=new Block(blocks.size());
+			blocks.push_back(cur);
+		}
+		cur->insts.push_back(inst);
+		inst->block=cur;
+	}
+}
+
+/*
+	Predecessor and successor lists
+*/
+void DFG::linkBlocks()
+{
+	for(int i=0;i<blocks.size();i++){
+		Block* b=blocks[i];
+		InterInst* last=b->insts.back();
+		if(last->isJmp()||last->isJcond())
+			b->succs.push_back(last->getTarget()->block);
+		vector<InterInst*>&table=last->getTable();//jump table, each label once
+		for(int k=0;k<table.size();k++)
+			if(find(b->succs.begin(),b->succs.end(),table[k]->block)==b->succs.end())
+				b->succs.push_back(table[k]->block);
+		//everything but an unconditional jump falls through, the exit ends the code
+		bool fall=!last->isJmp()&&last->getOp()!=OP_EXIT&&i+1<blocks.size();
+		if(fall&&(b->succs.empty()||b->succs[0]!=blocks[i+1]))
+			b->succs.push_back(blocks[i+1]);
+		for(int j=0;j<b->succs.size();j++)
+			b->succs[j]->prevs.push_back(b);
+	}
+}
+
+/*
+	Reverse post order of the blocks reachable from the entry,
+	iterative depth first search to stay safe on huge functions
+*/
+void DFG::computeOrder()
+{
+	if(blocks.empty())return;
+	vector<char> seen(blocks.size(),0);
+	vector<pair<Block*,int> > stack;//block and next successor to visit
+	vector<Block*> post;
+	stack.push_back(make_pair(blocks[0],0));
+	seen[0]=1;
+	while(!stack.empty()){
+		Block* b=stack.back().first;
+		int& next=stack.back().second;
+		if(next<b->succs.size()){
+			Block* s=b->succs[next++];
+			if(!seen[s->id]){
+				seen[s->id]=1;
+				stack.push_back(make_pair(s,0));
+			}
+		}
+		else{
+			post.push_back(b);
+			stack.pop_back();
+		}
+	}
+	order.assign(post.rbegin(),post.rend());
+	for(int i=0;i<order.size();i++)
+		order[i]->rpo=i;
+}
+
+/*
+	Cooper, Harvey, Kennedy: "A Simple, Fast Dominance Algorithm".
+	Iterate over reverse post order, intersecting the dominators of the
+	processed predecessors by walking up with rpo numbers.
+*/
+void DFG::computeDom()
+{
+	if(order.empty())return;
+	Block* entry=order[0];
+	entry->idom=entry;//temporary self loop to terminate intersections
+	bool changed=true;
+	while(changed){
+		changed=false;
+		for(int i=1;i<order.size();i++){
+			Block* b=order[i];
+			Block* dom=NULL;
+			for(int j=0;j<b->prevs.size();j++){
+				Block* p=b->prevs[j];
+				if(!p->idom)continue;//unprocessed or unreachable
+				if(!dom){
+					dom=p;
+					continue;
+				}
+				Block* x=p;
+				Block* y=dom;
+				while(x!=y){
+					while(x->rpo>y->rpo)x=x->idom;
+					while(y->rpo>x->rpo)y=y->idom;
+				}
+				dom=x;
+			}
+			if(dom!=b->idom){
+				b->idom=dom;
+				changed=true;
+			}
+		}
+	}
+	entry->idom=NULL;
+	for(int i=1;i<order.size();i++)
+		order[i]->idom->domKids.push_back(order[i]);
+}
+
+/*
+	Pre/post numbers of the dominator tree, a dominates b iff
+	a.pre <= b.pre and b.post <= a.post
+*/
+void DFG::numberDomTree()
+{
+	if(order.empty())return;
+	int counter=0;
+	vector<pair<Block*,int> > stack;
+	stack.push_back(make_pair(order[0],0));
+	order[0]->domPre=counter++;
+	while(!stack.empty()){
+		Block* b=stack.back().first;
+		int& next=stack.back().second;
+		if(next<b->domKids.size()){
+			Block* k=b->domKids[next++];
+			k->domPre=counter++;
+			stack.push_back(make_pair(k,0));
+		}
+		else{
+			b->domPost=counter++;
+			stack.pop_back();
+		}
+	}
+}
+
+/*
+	a dominates b
+*/
+bool DFG::dominates(Block* a,Block* b)
+{
+	if(!a->reachable()||!b->reachable())return false;
+	return a->domPre<=b->domPre&&b->domPost<=a->domPost;
+}
+
+/*
+	Natural loops. Headers are visited in post order so inner loops are
+	built first, an outer loop's backward walk jumps over an inner loop
+	through its header instead of revisiting its body.
+*/
+void DFG::findLoops()
+{
+	vector<Block*> work;
+	for(int i=order.size()-1;i>=0;i--){
+		Block* h=order[i];
+		Loop* loop=NULL;
+		for(int j=0;j<h->prevs.size();j++){
+			Block* p=h->prevs[j];
+			if(!dominates(h,p))continue;//not a back edge
+			if(!loop)loop=new Loop(h);
+			loop->latches.push_back(p);
+			work.push_back(p);
+		}
+		if(!loop)continue;
+		loops.push_back(loop);
+		h->loop=loop;
+		while(!work.empty()){
+			Block* b=work.back();
+			work.pop_back();
+			if(!b->loop){//new block of this loop
+				b->loop=loop;
+				for(int j=0;j<b->prevs.size();j++)
+					if(b->prevs[j]->reachable())work.push_back(b->prevs[j]);
+				continue;
+			}
+			Loop* sub=b->loop;
+			while(sub->parent)sub=sub->parent;
+			if(sub==loop)continue;//already in the body
+			sub->parent=loop;//outermost loop found so far is nested here
+			loop->kids.push_back(sub);
+			Block* sh=sub->header;
+			for(int j=0;j<sh->prevs.size();j++){
+				Block* p=sh->prevs[j];
+				if(!p->reachable())continue;
+				Loop* pl=p->loop;
+				while(pl&&pl->parent)pl=pl->parent;
+				if(pl!=loop)work.push_back(p);//entry edges of the inner loop
+			}
+		}
+	}
+	//depth from the outside in: outer loops come later in the list
+	for(int i=loops.size()-1;i>=0;i--)
+		loops[i]->depth=loops[i]->parent?loops[i]->parent->depth+1:1;
+	for(int i=0;i<order.size();i++){
+		Block* b=order[i];
+		if(!b->loop)continue;
+		b->loopDepth=b->loop->depth;
+		for(Loop* l=b->loop;l;l=l->parent)
+			l->blocks.push_back(b);
+	}
+	//header first
+	for(int i=0;i<loops.size();i++){
+		vector<Block*>& body=loops[i]->blocks;
+		for(int j=0;j<body.size();j++)
+			if(body[j]==loops[i]->header){
+				swap(body[0],body[j]);
+				break;
+			}
+	}
+}
+
+/*
+	All blocks in code order
+*/
+vector<Block*>& DFG::getBlocks()
+{
+	return blocks;
+}
+
+/*
+	Reachable blocks in reverse post order
+*/
+vector<Block*>& DFG::getOrder()
+{
+	return order;
+}
+
+/*
+	Loops, inner first
+*/
+vector<Loop*>& DFG::getLoops()
+{
+	return loops;
+}
+
+/*
+	Entry block
+*/
+Block* DFG::getEntry()
+{
+	return blocks.empty()?NULL:blocks[0];
+}
+
+/*
+	Exit block
+*/
+Block* DFG::getExit()
+{
+	return blocks.empty()?NULL:blocks.back();
+}
+
+/*
+	Mark the code of unreachable blocks isDead, returns the count.
+	Declarations stay for the frame layout and the exit block stays even
+	when the function never returns.
+*/
+int DFG::markUnreachable()
+{
+	int n=0;
+	for(int i=0;i<blocks.size();i++){
+		Block* b=blocks[i];
+		if(b->reachable()||b==getExit())continue;
+		for(int j=0;j<b->insts.size();j++){
+			InterInst* inst=b->insts[j];
+			if(!inst->isLb()&&inst->getOp()==OP_DEC)continue;
+			inst->isDead=true;
+			n++;
+		}
+	}
+	return n;
+}
+
+/*
+	Print blocks and loops
+*/
+void DFG::toString()
+{
+	for(int i=0;i<blocks.size();i++)
+		blocks[i]->toString();
+	for(int i=0;i<loops.size();i++){
+		Loop* l=loops[i];
+		printf("loop B%d depth=%d blocks:",l->header->id,l->depth);
+		for(int j=0;j<l->blocks.size();j++)printf(" B%d",l->blocks[j]->id);
+		printf("\n");
+	}
+}
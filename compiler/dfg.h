@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include "common.h"
+
+class InterInst;
+class InterCode;
+class Loop;
+
+/*
+	Basic block
+*/
+class Block
+{
+public:
+	int id;//index in code order
+	vector<InterInst*> insts;//instructions of the block
+	vector<Block*> prevs;//predecessors
+	vector<Block*> succs;//successors
+
+	int rpo;//position in reverse post order, -1 if unreachable
+	Block* idom;//immediate dominator, NULL for the entry and unreachable blocks
+	vector<Block*> domKids;//children in the dominator tree
+	int domPre,domPost;//dominator tree numbering for dominance queries
+
+	Loop* loop;//innermost loop containing the block, NULL outside loops
+	int loopDepth;//loop nesting depth, 0 outside loops
+
+	Block(int id);
+	bool reachable();//reached from the entry
+	void toString();//print the block
+};
+
+/*
+	Natural loop
+*/
+class Loop
+{
+public:
+	Block* header;//loop header, dominates the whole body
+	vector<Block*> latches;//sources of the back edges
+	vector<Block*> blocks;//body including nested loops, header first
+	Loop* parent;//enclosing loop
+	vector<Loop*> kids;//loops nested directly inside
+	int depth;//nesting depth, 1 for outermost loops
+
+	Loop(Block* header);
+	bool contains(Block* b);//block is in the body
+	bool contains(Loop* l);//loop is nested in this one or is this one
+};
+
+/*
+	Control flow graph of one function: basic blocks, reverse post order,
+	dominator tree and loop nest
+*/
+class DFG
+{
+	vector<Block*> blocks;//all blocks in code order, entry first and exit last
+	vector<Block*> order;//reachable blocks in reverse post order
+	vector<Loop*> loops;//loops, inner loops before the loops containing them
+
+	void createBlocks(vector<InterInst*>& code);//split code at leaders
+	void linkBlocks();//predecessor and successor lists
+	void computeOrder();//reverse post order
+	void computeDom();//Cooper-Harvey-Kennedy dominators
+	void numberDomTree();//pre/post numbers of the dominator tree
+	void findLoops();//natural loops and their nesting
+public:
+	DFG(InterCode& code);
+	~DFG();
+
+	vector<Block*>& getBlocks();//all blocks in code order
+	vector<Block*>& getOrder();//reachable blocks in reverse post order
+	vector<Loop*>& getLoops();//loops, inner first
+	Block* getEntry();//entry block
+	Block* getExit();//exit block
+	bool dominates(Block* a,Block* b);//a dominates b
+	int markUnreachable();//mark the code of unreachable blocks isDead, returns the count
+	void toString();//print blocks and loops
+};
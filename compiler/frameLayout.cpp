@@ -0,0 +1,221 @@
+#include "frameLayout.h"
+#include "symbol.h"
+#include "interCode.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+	Slot size of a variable, locals are 4 byte aligned
+*/
+static int slotSize(Var*var)
+{
+	int size=var->getSize();
+	return size+(4-size%4)%4;
+}
+
+/*
+	Compiler temporaries are named by GenIR::GenLb
+*/
+static bool isTemp(Var*var)
+{
+	return var->getName()[0]=='.';
+}
+
+FrameLayout::FrameLayout(Fun*fun):fun(fun),code(fun->getCode())
+{
+	before=fun->getMaxDep();
+	after=before;
+}
+
+/*
+	Frame size before
+*/
+int FrameLayout::getBefore()
+{
+	return before;
+}
+
+/*
+	Frame size after
+*/
+int FrameLayout::getAfter()
+{
+	return after;
+}
+
+/*
+	Replay the allocation of Fun::locate for named locals only: a scope's
+	space is released when the next declaration is outside of it.
+	Returns the size of the named area.
+*/
+int FrameLayout::layoutNamed(vector<Var*>&named)
+{
+	vector<pair<int,int> > scopes;//scope id and esp at its entry, one per path level
+	int esp=0,maxEsp=0;
+	for(int i=0;i<named.size();i++){
+		Var*var=named[i];
+		vector<int>&path=var->getPath();
+		while(scopes.size()>path.size()||
+			(!scopes.empty()&&scopes.back().first!=path[scopes.size()-1])){
+			esp=scopes.back().second;//leave the scope
+			scopes.pop_back();
+		}
+		while(scopes.size()<path.size())//enter the scopes down to the variable
+			scopes.push_back(make_pair(path[scopes.size()],esp));
+		esp+=slotSize(var);
+		var->setOffset(-esp);
+		if(esp>maxEsp)maxEsp=esp;
+	}
+	return maxEsp;
+}
+
+/*
+	A value is live around a back edge when its range starts before the
+	loop and ends inside it or starts inside and ends after it, such
+	ranges are widened to the whole loop until nothing changes.
+*/
+void FrameLayout::extendByLoops(vector<Range>&ranges,vector<Loop>&loops)
+{
+	if(loops.empty())return;
+	//loops ordered by head and by back edge for range queries
+	vector<pair<int,int> > heads,backs;
+	for(int i=0;i<loops.size();i++){
+		heads.push_back(make_pair(loops[i].head,i));
+		backs.push_back(make_pair(loops[i].back,i));
+	}
+	sort(heads.begin(),heads.end());
+	sort(backs.begin(),backs.end());
+	for(int r=0;r<ranges.size();r++){
+		Range&rg=ranges[r];
+		bool changed=true;
+		while(changed){
+			changed=false;
+			//loops whose head is in (start,end]
+			auto it=upper_bound(heads.begin(),heads.end(),make_pair(rg.start,(int)loops.size()));
+			for(;it!=heads.end()&&it->first<=rg.end;++it){
+				Loop&lp=loops[it->second];
+				if(lp.back>rg.end){rg.end=lp.back;changed=true;}
+			}
+			//loops whose back edge is in [start,end)
+			it=lower_bound(backs.begin(),backs.end(),make_pair(rg.start,-1));
+			for(;it!=backs.end()&&it->first<rg.end;++it){
+				Loop&lp=loops[it->second];
+				if(lp.head<rg.start){rg.start=lp.head;changed=true;}
+			}
+		}
+	}
+}
+
+/*
+	Linear scan over ranges sorted by start, a slot is free again after
+	the last use of its value. Returns the bytes used by the slots.
+*/
+int FrameLayout::colorTemps(vector<Range>&ranges,int base)
+{
+	sort(ranges.begin(),ranges.end(),[](const Range&a,const Range&b){
+		return a.start<b.start||(a.start==b.start&&a.end<b.end);
+	});
+	typedef pair<int,int> EndSlot;//range end and slot
+	priority_queue<EndSlot,vector<EndSlot>,greater<EndSlot> > active;
+	vector<int> freeSlots;
+	int slots=0;
+	for(int i=0;i<ranges.size();i++){
+		Range&rg=ranges[i];
+		while(!active.empty()&&active.top().first<=rg.start){
+			freeSlots.push_back(active.top().second);
+			active.pop();
+		}
+		int slot;
+		if(freeSlots.empty())slot=slots++;
+		else{
+			slot=freeSlots.back();
+			freeSlots.pop_back();
+		}
+		rg.var->setOffset(-(base+4*(slot+1)));
+		active.push(make_pair(rg.end,slot));
+	}
+	return 4*slots;
+}
+
+/*
+	Recompute local offsets and frame size
+*/
+void FrameLayout::relocate()
+{
+	if(fun->getExtern()||code.empty())return;
+	vector<Var*> named;//named locals in declaration order
+	vector<Var*> fixed;//temporaries that need their own slot
+	unordered_map<Var*,int> rangeId;//shareable temporary -> index in ranges
+	unordered_set<Var*> declared,addressed;
+	vector<Range> ranges;
+	vector<Loop> loops;
+	unordered_map<InterInst*,int> labelPos;
+	//declarations and address-taken variables
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())labelPos[inst]=i;
+		else if(inst->getOp()==OP_LEA)addressed.insert(inst->getArg1());
+	}
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(!inst->isDec())continue;
+		Var*var=inst->getArg1();
+		if(!declared.insert(var).second)continue;
+		if(var->regId>=0)continue;//lives in a register
+		if(!isTemp(var))named.push_back(var);
+		else if(var->getArray()||slotSize(var)!=4||addressed.count(var))fixed.push_back(var);
+		else{
+			Range rg={var,-1,-1};
+			rangeId[var]=ranges.size();
+			ranges.push_back(rg);
+		}
+	}
+	//live ranges from the first to the last reference
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		Var*refs[3];
+		int n=inst->getUses(refs);
+		Var*def=inst->getDef();
+		if(def)refs[n++]=def;
+		for(int k=0;k<n;k++){
+			auto it=rangeId.find(refs[k]);
+			if(it==rangeId.end())continue;
+			Range&rg=ranges[it->second];
+			if(rg.start<0){
+				//read before any write, keep it from the function entry
+				rg.start=(def==refs[k])?i:0;
+			}
+			rg.end=i;
+		}
+		if(inst->isJmp()||inst->isJcond()){
+			vector<InterInst*>targets(1,inst->getTarget());
+			vector<InterInst*>&table=inst->getTable();
+			targets.insert(targets.end(),table.begin(),table.end());
+			for(int t=0;t<targets.size();t++){
+				auto lb=labelPos.find(targets[t]);
+				if(lb!=labelPos.end()&&lb->second<i){
+					Loop lp={lb->second,i};
+					loops.push_back(lp);
+				}
+			}
+		}
+	}
+	//temporaries that are never referenced need no slot
+	int keep=0;
+	for(int i=0;i<ranges.size();i++)
+		if(ranges[i].start>=0)ranges[keep++]=ranges[i];
+	ranges.resize(keep);
+	extendByLoops(ranges,loops);
+	//named area, shared slots, then dedicated slots
+	int size=layoutNamed(named);
+	size+=colorTemps(ranges,size);
+	for(int i=0;i<fixed.size();i++){
+		size+=slotSize(fixed[i]);
+		fixed[i]->setOffset(-size);
+	}
+	size+=4*fun->getSaved().size();//callee saved registers at the bottom
+	after=size;
+	fun->setMaxDep(size);
+}
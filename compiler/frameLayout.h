@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "common.h"
+
+class Var;
+class Fun;
+class InterInst;
+
+/*
+	Stack frame layout.
+	Named locals keep the per-scope sharing of Fun::locate, compiler
+	temporaries get slots by live range so that temporaries whose ranges
+	do not overlap share a slot. Variables in registers get no slot, the
+	callee saved registers in use are kept below the locals.
+*/
+class FrameLayout
+{
+	//live range of a temporary in instruction positions
+	struct Range
+	{
+		Var*var;
+		int start;
+		int end;
+	};
+	//loop region [head,back] from a backward jump
+	struct Loop
+	{
+		int head;
+		int back;
+	};
+
+	Fun*fun;
+	vector<InterInst*>&code;
+	int before;//frame size from Fun::locate
+	int after;//frame size after relocation
+
+	int layoutNamed(vector<Var*>&named);//replay scope based allocation, returns the size
+	void extendByLoops(vector<Range>&ranges,vector<Loop>&loops);//keep values live around back edges
+	int colorTemps(vector<Range>&ranges,int base);//pack ranges into shared slots, returns slot bytes
+public:
+	FrameLayout(Fun*fun);
+
+	void relocate();//recompute local offsets and frame size
+	int getBefore();//frame size before
+	int getAfter();//frame size after
+};
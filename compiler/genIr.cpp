@@ -1,5 +1,8 @@
 #include "genIr.h"
 #include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include "symbol.h"
 
 
@@ -15,6 +18,8 @@ GenIR::GenIR(SymTab&tab):symtab(tab)
 {
 	symtab.SetIr(this);//构建符号表与代码生成器的一一关系
 	lbNum=0;
+	logic=NULL;
+	logicBegin=logicEnd=0;
 	push(NULL,NULL);//初始化作用域
 }
 
@@ -201,6 +206,223 @@ Var* GenIR::GenAnd(Var*lval,Var*rval)
 	return tmp;
 }
 
+/*
+	Conditional jump taken in the other case
+*/
+Operator GenIR::inverse(Operator op)
+{
+	switch(op){
+		case OP_JT:return OP_JF;
+		case OP_JF:return OP_JT;
+		case OP_JG:return OP_JLE;
+		case OP_JGE:return OP_JL;
+		case OP_JL:return OP_JGE;
+		case OP_JLE:return OP_JG;
+		case OP_JE:return OP_JNE;
+		default:return OP_JE;
+	}
+}
+
+/*
+	回填跳转目标
+*/
+void GenIR::backpatch(vector<InterInst*>&jumps,InterInst*target)
+{
+	for(int i=0;i<jumps.size();i++)
+		jumps[i]->replace(jumps[i]->getOp(),target,jumps[i]->getArg1(),jumps[i]->getArg2());
+	jumps.clear();
+}
+
+/*
+	Jumping form of a condition, preferring to fall through with the value
+	fallTrue. The value of the last && or || still at the end of the code
+	is taken back to its jumps, any other value is tested once.
+*/
+GenIR::Cond GenIR::GenCond(Var*cond,bool fallTrue)
+{
+	vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+	if(cond&&cond==logic&&code.size()==logicEnd){
+		for(int i=logicBegin;i<code.size();i++)delete code[i];//drop the 0/1 assignments
+		code.resize(logicBegin);
+		logic=NULL;
+		Cond c=logicCond;
+		//the last test jumps on the other value when inverted
+		vector<InterInst*>&last=c.fallTrue?c.falses:c.trues;
+		if(c.fallTrue!=fallTrue&&!last.empty()&&last.back()==code.back()){
+			InterInst*jmp=last.back();
+			last.pop_back();
+			jmp->replace(inverse(jmp->getOp()),(InterInst*)NULL,jmp->getArg1(),jmp->getArg2());
+			(fallTrue?c.falses:c.trues).push_back(jmp);
+			c.fallTrue=fallTrue;
+		}
+		return c;
+	}
+	Cond c;
+	c.left=NULL;
+	c.fallTrue=fallTrue;
+	if(cond->IsRef())cond=GenAssign(cond);//if(*p&&...)
+	//a negation or a comparison made only for this test goes into the jump
+	bool onTrue=!fallTrue;
+	InterInst*jmp=NULL;
+	while(!jmp){
+		int n=code.size();
+		InterInst*last=n>=2?code[n-1]:NULL;
+		Operator op=last&&!last->isLb()?last->getOp():OP_NOP;
+		if(op!=OP_NOT&&(op<OP_GT||op>OP_NE)||last->getResult()!=cond||
+			code[n-2]->getOp()!=OP_DEC||code[n-2]->getArg1()!=cond){
+			jmp=new InterInst(onTrue?OP_JT:OP_JF,(InterInst*)NULL,cond);
+			break;
+		}
+		Var*a=last->getArg1(),*b=last->getArg2();
+		delete code[n-1];
+		delete code[n-2];
+		code.resize(n-2);
+		if(op==OP_NOT){//if(!x) tests x
+			cond=a;
+			onTrue=!onTrue;
+			continue;
+		}
+		op=(Operator)(OP_JG+op-OP_GT);//JG..JNE follow GT..NE, if(a>b) tests a>b
+		jmp=new InterInst(onTrue?op:inverse(op),(InterInst*)NULL,a,b);
+	}
+	symtab.AddInst(jmp);
+	(fallTrue?c.falses:c.trues).push_back(jmp);
+	return c;
+}
+
+/*
+	0/1 value of a condition, remembered so that a test of it can take the
+	jumps back: tmp=1 goto exit; tmp=0; exit
+*/
+Var* GenIR::GenLogicValue(Cond&c)
+{
+	vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+	logicBegin=code.size();
+	Var*tmp=new Var(symtab.GetScopePath(),KW_INT,false);//基本类型
+	symtab.AddVar(tmp);
+	logicCond=c;
+	InterInst*_exit=new InterInst();
+	for(int k=0;k<2;k++){
+		bool val=c.fallTrue==(k==0);//the value falling through comes first
+		vector<InterInst*>&jumps=val?c.trues:c.falses;
+		if(!jumps.empty()){
+			InterInst*lb=new InterInst();
+			symtab.AddInst(lb);
+			backpatch(jumps,lb);
+		}
+		symtab.AddInst(new InterInst(OP_AS,tmp,val?Var::getTrue():Var::getFalse()));
+		if(k==0)symtab.AddInst(new InterInst(OP_JMP,_exit));
+	}
+	symtab.AddInst(_exit);
+	logic=tmp;
+	logicEnd=code.size();
+	return tmp;
+}
+
+/*
+	Jump to target when cond is onTrue, fall through otherwise
+*/
+void GenIR::GenCondJump(Var*cond,InterInst*target,bool onTrue)
+{
+	Cond c=GenCond(cond,!onTrue);
+	if(c.fallTrue==onTrue)symtab.AddInst(new InterInst(OP_JMP,target));
+	backpatch(onTrue?c.trues:c.falses,target);
+	vector<InterInst*>&other=onTrue?c.falses:c.trues;
+	if(!other.empty()){
+		InterInst*lb=new InterInst();
+		symtab.AddInst(lb);
+		backpatch(other,lb);
+	}
+}
+
+/*
+	&&左部：为假时跳过右部，为真时落入右部
+*/
+void GenIR::GenAndHead(Var*lval)
+{
+	Cond c;
+	c.fallTrue=true;
+	if(lval&&symtab.GetCurFun()){
+		c=GenCond(lval,true);
+		if(!c.fallTrue){
+			InterInst*jmp=new InterInst(OP_JMP,(InterInst*)NULL);
+			symtab.AddInst(jmp);
+			c.falses.push_back(jmp);
+		}
+		if(!c.trues.empty()){
+			InterInst*lb=new InterInst();//右部
+			symtab.AddInst(lb);
+			backpatch(c.trues,lb);
+		}
+	}
+	c.left=lval;
+	logics.push_back(c);
+}
+
+/*
+	&&右部：左部的假跳转与右部的跳转合并，产生0/1的值
+*/
+Var* GenIR::GenAndTail(Var*rval)
+{
+	Cond c=logics.back();
+	logics.pop_back();
+	if(!rval||!c.left||!symtab.GetCurFun()){//void or outside a function
+		if(!c.falses.empty()){
+			InterInst*lb=new InterInst();
+			symtab.AddInst(lb);
+			backpatch(c.falses,lb);
+		}
+		return GenTwoOp(c.left,AND,rval);
+	}
+	Cond r=GenCond(rval,true);
+	r.falses.insert(r.falses.begin(),c.falses.begin(),c.falses.end());
+	return GenLogicValue(r);
+}
+
+/*
+	||左部：为真时跳过右部，为假时落入右部
+*/
+void GenIR::GenOrHead(Var*lval)
+{
+	Cond c;
+	c.fallTrue=false;
+	if(lval&&symtab.GetCurFun()){
+		c=GenCond(lval,false);
+		if(c.fallTrue){
+			InterInst*jmp=new InterInst(OP_JMP,(InterInst*)NULL);
+			symtab.AddInst(jmp);
+			c.trues.push_back(jmp);
+		}
+		if(!c.falses.empty()){
+			InterInst*lb=new InterInst();//右部
+			symtab.AddInst(lb);
+			backpatch(c.falses,lb);
+		}
+	}
+	c.left=lval;
+	logics.push_back(c);
+}
+
+/*
+	||右部：左部的真跳转与右部的跳转合并，产生0/1的值
+*/
+Var* GenIR::GenOrTail(Var*rval)
+{
+	Cond c=logics.back();
+	logics.pop_back();
+	if(!rval||!c.left||!symtab.GetCurFun()){//void or outside a function
+		if(!c.trues.empty()){
+			InterInst*lb=new InterInst();
+			symtab.AddInst(lb);
+			backpatch(c.trues,lb);
+		}
+		return GenTwoOp(c.left,OR,rval);
+	}
+	Cond r=GenCond(rval,true);
+	r.trues.insert(r.trues.begin(),c.trues.begin(),c.trues.end());
+	return GenLogicValue(r);
+}
+
 /*
 	大于语句
 */
@@ -381,6 +603,12 @@ Var* GenIR::GenOneOpLeft(Tag opt,Var*val)
 */
 Var* GenIR::GenNot(Var*val)
 {
+	if(logic&&val==logic&&symtab.GetCurFun()->getCode().size()==logicEnd){//!(a&&b): swap the jumps
+		Cond c=GenCond(val,true);
+		c.trues.swap(c.falses);
+		c.fallTrue=!c.fallTrue;
+		return GenLogicValue(c);
+	}
 	Var*tmp=new Var(symtab.GetScopePath(),KW_INT,false);//生成整数
 	symtab.AddVar(tmp);
 	symtab.AddInst(new InterInst(OP_NOT,tmp,val));//中间代码tmp=-val
@@ -453,6 +681,7 @@ Var* GenIR::GenLea(Var*val)
 		Var* tmp=new Var(symtab.GetScopePath(),val->getType(),true);//产生局部变量tmp
 		symtab.AddVar(tmp);//插入声明
 		symtab.AddInst(new InterInst(OP_LEA,tmp,val));//中间代码tmp=&val
+		val->inMem=true;//may now be read and written through the pointer
 		return tmp;
 	}
 }
@@ -544,18 +773,31 @@ void GenIR::GenWhileHead(InterInst*& _while,InterInst*& _exit)
 
 	_exit=new InterInst();//产生exit标签
 	push(_while,_exit);//进入while
+	Rotation r;
+	r.cond=symtab.GetCurFun()->getCode().size();
+	rotations.push_back(r);
 }
 
 /*
-	产生while条件
+	产生while条件：a rotated loop goes on with its body, continue jumps
+	to the test at the bottom
 */
 void GenIR::GenWhileCond(Var*cond,InterInst* _exit)
 {
+	Rotation&r=rotations.back();
 	if(cond){
 		if(cond->isVoid())cond=Var::getTrue();//处理空表达式
-		else if(cond->IsRef())cond=GenAssign(cond);//while(*p),while(a[0])
-		symtab.AddInst(new InterInst(OP_JF,_exit,cond));
+		GenCondJump(cond,_exit,false);//while(*p),while(a[0]),while(a&&b)
 	}
+	r.condEnd=symtab.GetCurFun()->getCode().size();
+	if(!rotatable(r,_exit)){
+		r.cond=-1;
+		return;
+	}
+	r.body=new InterInst();
+	symtab.AddInst(r.body);
+	r.next=new InterInst();
+	heads.back()=r.next;
 }
 
 /*
@@ -563,9 +805,15 @@ void GenIR::GenWhileCond(Var*cond,InterInst* _exit)
 */
 void GenIR::GenWhileTail(InterInst*& _while,InterInst*& _exit)
 {
-	symtab.AddInst(new InterInst(OP_JMP,_while));//添加jmp指令
+	Rotation&r=rotations.back();
+	if(r.cond>=0){
+		symtab.AddInst(r.next);
+		GenCondCopy(r,_exit);//if(cond)goto body
+	}
+	else symtab.AddInst(new InterInst(OP_JMP,_while));//添加jmp指令
 	symtab.AddInst(_exit);//添加exit标签
 	pop();//离开while
+	rotations.pop_back();
 }
 
 /*
@@ -586,8 +834,7 @@ void GenIR::GenDoWhileTail(Var*cond,InterInst* _do,InterInst* _exit)
 {
 	if(cond){
 		if(cond->isVoid())cond=Var::getTrue();//处理空表达式
-		else if(cond->IsRef())cond=GenAssign(cond);//while(*p),while(a[0])
-		symtab.AddInst(new InterInst(OP_JT,_do,cond));
+		GenCondJump(cond,_do,true);//while(*p),while(a[0]),while(a&&b)
 	}
 	symtab.AddInst(_exit);
 	pop();
@@ -601,6 +848,9 @@ void GenIR::GenForHead(InterInst*& _for,InterInst*& _exit)
 	_for=new InterInst();//产生for标签
 	_exit=new InterInst();//产生exit标签
 	symtab.AddInst(_for);
+	Rotation r;
+	r.cond=symtab.GetCurFun()->getCode().size();
+	rotations.push_back(r);
 }
 
 /*
@@ -610,12 +860,18 @@ void GenIR::GenForCondBegin(Var*cond,InterInst*& _step,InterInst*& _block,InterI
 {
 	_block=new InterInst();//产生block标签
 	_step=new InterInst();//产生循环动作标签
+	Rotation&r=rotations.back();
+	r.body=_block;
 	if(cond){
 		if(cond->isVoid())cond=Var::getTrue();//处理空表达式
-		else if(cond->IsRef())cond=GenAssign(cond);//for(*p),for(a[0])
-		symtab.AddInst(new InterInst(OP_JF,_exit,cond));
+		GenCondJump(cond,_exit,false);//for(*p),for(a[0]),for(;a&&b;)
+	}
+	r.condEnd=symtab.GetCurFun()->getCode().size();
+	if(!rotatable(r,_exit)){
+		r.cond=-1;
 		symtab.AddInst(new InterInst(OP_JMP,_block));//执行循环体
 	}
+	r.step=symtab.GetCurFun()->getCode().size();
 	symtab.AddInst(_step);//添加循环动作标签
 	push(_step,_exit);//进入for
 }
@@ -625,18 +881,98 @@ void GenIR::GenForCondBegin(Var*cond,InterInst*& _step,InterInst*& _block,InterI
 */
 void GenIR::GenForCondEnd(InterInst* _for,InterInst* _block)
 {
-	symtab.AddInst(new InterInst(OP_JMP,_for));//继续循环
+	Rotation&r=rotations.back();
+	if(r.cond<0)symtab.AddInst(new InterInst(OP_JMP,_for));//继续循环
+	r.stepEnd=symtab.GetCurFun()->getCode().size();
 	symtab.AddInst(_block);//添加循环体标签
 }
 
 /*
-	产生for尾部
+	产生for尾部：a rotated loop moves its step after the body, the test
+	follows it
 */
 void GenIR::GenForTail(InterInst*& _step,InterInst*& _exit)
 {
-	symtab.AddInst(new InterInst(OP_JMP,_step));//跳转到循环动作
+	Rotation&r=rotations.back();
+	if(r.cond>=0){
+		vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+		rotate(code.begin()+r.step,code.begin()+r.stepEnd,code.end());
+		logic=NULL;//its code moved
+		GenCondCopy(r,_exit);//if(cond)goto block
+	}
+	else symtab.AddInst(new InterInst(OP_JMP,_step));//跳转到循环动作
 	symtab.AddInst(_exit);//添加_exit标签
 	pop();//离开for
+	rotations.pop_back();
+}
+
+/*
+	The condition of a loop can be copied to its bottom: it is small, ends
+	with the jump out of the loop when it fails, and its other jumps stay
+	inside it or leave the loop too. A loop without condition only jumps
+	back.
+*/
+bool GenIR::rotatable(Rotation&r,InterInst*_exit)
+{
+	if(r.cond==r.condEnd)return true;//for(;;)
+	vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+	int last=r.condEnd-1;
+	while(last>=r.cond&&code[last]->isLb())last--;
+	if(last<r.cond)return false;
+	InterInst*test=code[last];
+	if(test->getOp()!=OP_JMP&&!test->isJcond()||test->getTarget()!=_exit)return false;
+	unordered_set<InterInst*>labels;
+	int size=0;
+	for(int i=r.cond;i<r.condEnd;i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())labels.insert(inst);
+		else if(inst->getOp()==OP_DEC){
+			if(!inst->getArg1()->unInit())return false;
+		}
+		else if(++size>ROTATE_SIZE||inst->isJmp()&&inst->getOp()!=OP_JMP)return false;
+	}
+	for(int i=r.cond;i<r.condEnd;i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->getOp()!=OP_JMP&&!inst->isJcond())continue;
+		if(inst->getTarget()!=_exit&&!labels.count(inst->getTarget()))return false;
+	}
+	return true;
+}
+
+/*
+	Copy of the condition at the bottom of the loop: the labels after its
+	last test are where it holds and become the body, the last test jumps
+	back to the body instead of out of the loop, which now follows
+*/
+void GenIR::GenCondCopy(Rotation&r,InterInst*_exit)
+{
+	if(r.cond==r.condEnd){
+		symtab.AddInst(new InterInst(OP_JMP,r.body));//goto body
+		return;
+	}
+	vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+	int last=r.condEnd-1;
+	while(code[last]->isLb())last--;
+	unordered_map<InterInst*,InterInst*>labels;
+	labels[_exit]=_exit;
+	for(int i=r.cond;i<r.condEnd;i++)
+		if(code[i]->isLb())labels[code[i]]=i<last?new InterInst():r.body;
+	for(int i=r.cond;i<=last;i++){
+		InterInst*inst=code[i];
+		Operator op=inst->getOp();
+		if(inst->isLb())symtab.AddInst(labels[inst]);
+		else if(op==OP_DEC)continue;//declared by the test at the top
+		else if(i==last){//if(!cond)goto exit => if(cond)goto body
+			if(op!=OP_JMP)
+				symtab.AddInst(new InterInst(inverse(op),r.body,inst->getArg1(),inst->getArg2()));
+		}
+		else if(op==OP_CALL||op==OP_PROC)
+			symtab.AddInst(new InterInst(op,inst->getFun(),inst->getResult()));
+		else if(op==OP_JMP||inst->isJcond())
+			symtab.AddInst(new InterInst(op,labels[inst->getTarget()],inst->getArg1(),inst->getArg2()));
+		else
+			symtab.AddInst(new InterInst(op,inst->getResult(),inst->getArg1(),inst->getArg2()));
+	}
 }
 
 /*
@@ -646,8 +982,7 @@ void GenIR::GenIfHead(Var*cond,InterInst*& _else)
 {
 	_else=new InterInst();//产生else标签
 	if(cond){
-		if(cond->IsRef())cond=GenAssign(cond);//if(*p),if(a[0])
-		symtab.AddInst(new InterInst(OP_JF,_else,cond));
+		GenCondJump(cond,_else,false);//if(*p),if(a[0]),if(a&&b)
 	}
 }
 
@@ -678,42 +1013,96 @@ void GenIR::GenElseTail(InterInst*& _exit)
 }
 
 /*
-	产生switch头部
+	产生switch头部，cond已经求值，分派代码将插在这里
 */
-void GenIR::GenSwitchHead(InterInst*& _exit)
+void GenIR::GenSwitchHead(Var*cond,InterInst*& _exit)
 {
 	_exit=new InterInst();//产生exit标签
 	push(NULL,_exit);//进入switch，不允许continue，因此head=NULL
+	Switch s;
+	s.cond=cond;
+	s.head=symtab.GetCurFun()->getCode().size();
+	s.def=NULL;
+	switches.push_back(s);
 }
 
 /*
-	产生switch尾部
+	Dispatch on the sorted cases l..r-1: a jump table when their values are
+	dense, tests one by one when they are few, otherwise a test against the
+	middle value splits them in two
+*/
+void GenIR::GenDispatch(Switch&s,int l,int r,InterInst*def,vector<InterInst*>&out)
+{
+	vector<Case>&cases=s.cases;
+	int n=r-l;
+	long long span=(long long)cases[r-1].val-cases[l].val+1;
+	if(n>=SWITCH_TABLE&&span<=(long long)n*SWITCH_DENSITY){
+		vector<InterInst*>table(span,def);//holes go to default
+		for(int i=l;i<r;i++)table[cases[i].val-cases[l].val]=cases[i].label;
+		out.push_back(new InterInst(OP_JTAB,def,table,s.cond,cases[l].lb));
+		return;
+	}
+	if(n<=SWITCH_LINEAR){
+		for(int i=l;i<r;i++)//if(cond==lb)goto label
+			out.push_back(new InterInst(OP_JE,cases[i].label,s.cond,cases[i].lb));
+		out.push_back(new InterInst(OP_JMP,def));
+		return;
+	}
+	int m=l+n/2;
+	InterInst*low=new InterInst();
+	out.push_back(new InterInst(OP_JL,low,s.cond,cases[m].lb));//if(cond<lb)goto low
+	GenDispatch(s,m,r,def,out);
+	out.push_back(low);
+	GenDispatch(s,l,m,def,out);
+}
+
+/*
+	产生switch尾部：the statements of the cases follow each other so that
+	a case without break falls into the next one, the dispatch jumps to
+	them from the head
 */
 void GenIR::GenSwitchTail(InterInst* _exit)
 {
 	symtab.AddInst(_exit);//添加exit标签
 	pop();
+	Switch&s=switches.back();
+	vector<Case>&cases=s.cases;
+	stable_sort(cases.begin(),cases.end());
+	int n=0;
+	for(int i=0;i<cases.size();i++){
+		if(n&&cases[n-1].val==cases[i].val)SEMERROR(CASE_RE_DEF);//the first one is kept
+		else cases[n++]=cases[i];
+	}
+	cases.resize(n);
+	vector<InterInst*>out;
+	if(n)GenDispatch(s,0,n,s.def?s.def:_exit,out);
+	else out.push_back(new InterInst(OP_JMP,s.def?s.def:_exit));//no case, the body is only entered at default
+	vector<InterInst*>&code=symtab.GetCurFun()->getCode();
+	code.insert(code.begin()+s.head,out.begin(),out.end());
+	if(logicEnd>s.head)logic=NULL;//its code moved
+	switches.pop_back();
 }
 
 /*
 	产生case头部
 */
-void GenIR::GenCaseHead(Var*cond,Var*lb,InterInst*& _case_exit)
+void GenIR::GenCaseHead(Var*lb)
 {
-	_case_exit=new InterInst();//产生case的exit标签
-	if(lb)symtab.AddInst(new InterInst(OP_JNE,_case_exit,cond,lb));//if(cond!=lb)goto _case_exit
+	InterInst*label=new InterInst();//产生case标签
+	symtab.AddInst(label);
+	if(!lb)return;
+	Case c={lb->getVal(),lb,label};
+	switches.back().cases.push_back(c);
 }
 
 /*
-	产生case尾部
+	产生default头部
 */
-void GenIR::GenCaseTail(InterInst* _case_exit)
+void GenIR::GenDefaultHead()
 {
-	symtab.AddInst(_case_exit);//添加case的exit标签
-	// InterInst * _case_exit_append=new InterInst();//产生case的exit附加标签
-	// symtab.AddInst(new InterInst(OP_JMP,_case_exit_append));//goto _case_exit_append
-	// symtab.AddInst(_case_exit);//添加case的exit标签
-	// symtab.AddInst(_case_exit_append);//添加case的exit附加标签
+	InterInst*label=new InterInst();//产生default标签
+	symtab.AddInst(label);
+	switches.back().def=label;
 }
 
 /*
@@ -749,7 +1138,8 @@ void GenIR::GenBreak()
 */
 void GenIR::GenContinue()
 {
-	InterInst*head=heads.back();//取出跳出标签
+	InterInst*head=NULL;//取出跳出标签，switch不接受continue
+	for(int i=heads.size()-1;i>=0&&!head;i--)head=heads[i];
 	if(head)symtab.AddInst(new InterInst(OP_JMP,head));//goto head
 	else SEMERROR(CONTINUE_ERR);//continue不在循环中
 }
@@ -759,8 +1149,11 @@ void GenIR::GenContinue()
 */
 void GenIR::GenReturn(Var*ret)
 {
-	if(!ret)return;
 	Fun*fun=symtab.GetCurFun();
+	if(!ret){//bare return, or the value of a void call
+		if(fun->getType()==KW_VOID)symtab.AddInst(new InterInst(OP_RET,fun->getReturnPoint()));
+		return;
+	}
 	if(ret->isVoid()&&fun->getType()!=KW_VOID||ret->isBase()&&fun->getType()==KW_VOID){//类型不兼容
 		SEMERROR(RETURN_ERR);//return语句和函数返回值类型不匹配
 		return;
@@ -4,6 +4,11 @@
 #include "symbolTable.h"
 #include "interCode.h"
 
+#define SWITCH_LINEAR 3//cases tested one by one
+#define SWITCH_TABLE 4//cases a jump table needs at least
+#define SWITCH_DENSITY 3//values a jump table may span per case
+#define ROTATE_SIZE 16//instructions of a loop condition copied to the bottom
+
 /*
 	中间代码生成器
 */
@@ -19,6 +24,54 @@ class GenIR
 	void push(InterInst*head,InterInst*tail);//添加一个作用域
 	void pop();//删除一个作用域
 	
+	//switch-case：分派代码在switch结束时生成，插入到条件之后
+	struct Case
+	{
+		int val;//case值
+		Var*lb;//its literal
+		InterInst*label;//start of its statements
+		bool operator<(const Case&c)const{return val<c.val;}
+	};
+	struct Switch
+	{
+		Var*cond;//value switched on
+		int head;//code index of the dispatch
+		vector<Case>cases;
+		InterInst*def;//default标签，没有时为NULL
+	};
+	vector<Switch>switches;//switch statements being generated
+	void GenDispatch(Switch&s,int l,int r,InterInst*def,vector<InterInst*>&out);//dispatch on cases l..r-1
+	
+	//循环旋转：条件在入口测试一次，复制到循环底部成为唯一的回边
+	struct Rotation
+	{
+		int cond,condEnd;//code range of the condition, cond<0 when the loop is not rotated
+		int step,stepEnd;//code range of the step of a for loop, moved after the body
+		InterInst*body;//start of the body
+		InterInst*next;//test at the bottom, continue of a while loop
+	};
+	vector<Rotation>rotations;//loops being generated
+	bool rotatable(Rotation&r,InterInst*_exit);//the condition can be copied
+	void GenCondCopy(Rotation&r,InterInst*_exit);//copy of the condition jumping back to the body
+	
+	
+	//短路求值：条件的跳转形式，目标未定的跳转在链表中等待回填
+	struct Cond
+	{
+		vector<InterInst*>trues;//jumps taken when the condition holds
+		vector<InterInst*>falses;//jumps taken when it does not
+		bool fallTrue;//falling through means the condition holds
+		Var*left;//left operand of && and ||
+	};
+	vector<Cond>logics;//left parts of the && and || being generated
+	Var*logic;//value of the last && or ||, materialized at the end of the code
+	Cond logicCond;//its jumping form
+	int logicBegin,logicEnd;//code range of the materialization
+
+	void backpatch(vector<InterInst*>&jumps,InterInst*target);//回填跳转目标
+	Cond GenCond(Var*cond,bool fallTrue);//jumping form of a condition
+	Var* GenLogicValue(Cond&c);//0/1 value of a condition
+	void GenCondJump(Var*cond,InterInst*target,bool onTrue);//jump to target when cond is onTrue
 	
 	//函数调用
 	void GenPara(Var*arg);//参数传递语句
@@ -61,6 +114,10 @@ public:
 	Var* GenTwoOp(Var*lval,Tag opt,Var*rval);//双目运算语句	
 	Var* GenOneOpLeft(Tag opt,Var*val);//左单目运算语句	
 	Var* GenOneOpRight(Var*val,Tag opt);//右单目运算语句
+	void GenAndHead(Var*lval);//&&左部，为假时跳过右部
+	Var* GenAndTail(Var*rval);//&&右部
+	void GenOrHead(Var*lval);//||左部，为真时跳过右部
+	Var* GenOrTail(Var*rval);//||右部
 	
 	//产生复合语句
 	void GenWhileHead(InterInst*& _while,InterInst*& _exit);//while循环头部
@@ -76,10 +133,10 @@ public:
 	void GenIfTail(InterInst*& _else);//if尾部
 	void GenElseHead(InterInst* _else,InterInst*& _exit);//else头部
 	void GenElseTail(InterInst*& _exit);//else尾部
-	void GenSwitchHead(InterInst*& _exit);//switch头部
+	void GenSwitchHead(Var*cond,InterInst*& _exit);//switch头部
 	void GenSwitchTail(InterInst* _exit);//switch尾部
-	void GenCaseHead(Var*cond,Var*lb,InterInst*& _case_exit);//case头部
-	void GenCaseTail(InterInst* _case_exit);//case尾部	
+	void GenCaseHead(Var*lb);//case头部
+	void GenDefaultHead();//default头部
 	
 	//产生特殊语句
 	void GenBreak();//产生break语句
@@ -91,6 +148,7 @@ public:
 	
 	//全局函数
 	static string GenLb();//产生唯一的标签	
+	static Operator inverse(Operator op);//conditional jump taken in the other case
 	static bool typeCheck(Var*lval,Var*rval);//检查类型是否可以转换
 };
 
@@ -0,0 +1,379 @@
+#include "indVar.h"
+#include "liveVar.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <unordered_set>
+#include <cstdlib>
+
+InductionVar::InductionVar(Fun*fun,SymTab*tab):fun(fun),tab(tab),ivs(0),muls(0),adds(0),tests(0)
+{
+}
+
+/*
+	Literal variable
+*/
+Var* InductionVar::literal(int val)
+{
+	unordered_map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	Literal value of v on entry, found on the single predecessor chain
+	above b
+*/
+bool InductionVar::entryValue(Block*b,Var*v,int&val)
+{
+	for(int n=0;b&&n<8;n++){
+		for(int j=b->insts.size()-1;j>=0;j--){
+			InterInst*inst=b->insts[j];
+			if(inst->getDef()!=v)continue;
+			Var*src=inst->getArg1();
+			if(inst->getOp()!=OP_AS||src->notConst())return false;
+			val=src->getVal();
+			return true;
+		}
+		b=b->prevs.size()==1?b->prevs[0]:NULL;
+	}
+	return false;
+}
+
+/*
+	Reduce the derived values of the basic induction variables of a loop,
+	then try to replace its exit test. The derived value of an address
+	addition must be computed in the same block, with no update of i in
+	between, so it still belongs to the current i.
+*/
+bool InductionVar::reduce(DFG*dfg,LiveVar*live,Loop*loop,Plan&plan)
+{
+	for(int i=0;i<seen.size();i++){
+		int v=seen[i];
+		defs[v]=uses[v]=step[v]=0;
+		defOf[v]=NULL;
+	}
+	seen.clear();
+	Block*h=loop->header;
+	InterInst*lb=h->insts[0];
+	if(!lb->isLb())return false;
+	//the preheader goes right before the label, nothing in the loop may fall into it
+	vector<Block*>&all=dfg->getBlocks();
+	if(h->id>0){
+		Block*lp=all[h->id-1];
+		if(loop->contains(lp)&&(lp->insts.empty()||!lp->insts.back()->isJmp()))return false;
+	}
+	//definitions in the loop
+	VarIndex&vars=live->getVars();
+	vector<Block*>targets;//blocks entered when leaving the loop
+	for(int i=0;i<loop->blocks.size();i++){
+		Block*b=loop->blocks[i];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb())continue;
+			Var*read[2];
+			int n=inst->getUses(read);
+			for(int u=0;u<n;u++)
+				if(VarIndex::tracked(read[u])){
+					uses[read[u]->index]++;
+					seen.push_back(read[u]->index);
+				}
+			Var*def=inst->getDef();
+			if(!VarIndex::tracked(def))continue;
+			defs[def->index]++;
+			seen.push_back(def->index);
+			defOf[def->index]=inst;
+		}
+		for(int j=0;j<b->succs.size();j++)
+			if(!loop->contains(b->succs[j]))targets.push_back(b->succs[j]);
+	}
+	//basic induction variables: step of each, 0 for other variables
+	for(int i=0;i<seen.size();i++){
+		int v=seen[i];
+		Var*iv=vars.get(v);
+		InterInst*inst=defOf[v];
+		if(defs[v]!=1||inst->block->loop!=loop)continue;//once per iteration at most
+		if(iv->getType()!=KW_INT||iv->getPtr()||iv->getArray()||vars.isMem(iv))continue;
+		Var*a=inst->getArg1(),*b=inst->getArg2();
+		if(inst->getOp()==OP_ADD&&a==iv&&!b->notConst())step[v]=b->getVal();
+		else if(inst->getOp()==OP_ADD&&b==iv&&!a->notConst())step[v]=a->getVal();
+		else if(inst->getOp()==OP_SUB&&a==iv&&!b->notConst())step[v]=-b->getVal();
+	}
+	#define IV(x) (VarIndex::tracked(x)&&step[(x)->index])
+	//derived values: i*k, a+i, and a+x after x=i*k in the same block
+	struct Derived{InterInst*inst;Var*iv;int k;Var*base;InterInst*mul;};
+	vector<Derived>found;
+	unordered_map<InterInst*,int>feeds;//multiplication -> reduced additions reading it
+	for(int bi=0;bi<loop->blocks.size();bi++){
+		Block*b=loop->blocks[bi];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb())continue;
+			Operator op=inst->getOp();
+			Var*res=inst->getResult();
+			Var*a=inst->getArg1(),*c=inst->getArg2();
+			Var*iv=NULL,*base=NULL;
+			InterInst*mul=NULL;
+			int k=0;
+			if(op==OP_MUL){
+				if(res->getType()!=KW_INT||res->getPtr())continue;
+				if(IV(a)&&!c->notConst()){iv=a;k=c->getVal();}
+				else if(IV(c)&&!a->notConst()){iv=c;k=a->getVal();}
+			}
+			else if(op==OP_ADD){
+				for(int side=0;!iv&&side<2;side++){
+					Var*x=side?a:c;
+					base=side?c:a;
+					bool inv=base->getArray()||base->getPtr()&&VarIndex::tracked(base)&&
+						!vars.isMem(base)&&defs[base->index]==0;
+					if(!inv||!VarIndex::tracked(x)||!x->notConst())continue;
+					if(IV(x)){iv=x;k=1;continue;}
+					if(defs[x->index]!=1||defOf[x->index]->block!=b)continue;
+					//x=i*k earlier in the block, i unchanged since
+					for(int p=j-1;p>=0;p--){
+						InterInst*d=b->insts[p];
+						if(d==defOf[x->index]){
+							Var*d1=d->getArg1(),*d2=d->getArg2();
+							if(d->getOp()!=OP_MUL)break;
+							if(IV(d1)&&!d2->notConst()){iv=d1;k=d2->getVal();}
+							else if(IV(d2)&&!d1->notConst()){iv=d2;k=d1->getVal();}
+							if(iv)mul=d;
+							break;
+						}
+						if(!d->isLb()&&IV(d->getDef()))break;
+					}
+				}
+				if(!iv)base=NULL;
+			}
+			if(!iv||k==0||!VarIndex::tracked(res)||vars.isMem(res))continue;
+			long long inc=(long long)step[iv->index]*k;
+			if(inc!=(int)inc)continue;
+			Derived d={inst,iv,k,base,mul};
+			found.push_back(d);
+			if(mul)feeds[mul]++;
+		}
+	}
+	vector<Family>fams;
+	vector<pair<InterInst*,int> >copies;//instruction -> family it copies
+	unordered_set<InterInst*>rewritten;//no longer reads i once the pass is done
+	for(int i=0;i<found.size();i++){
+		Derived&d=found[i];
+		Var*res=d.inst->getResult();
+		if(!d.base&&feeds.count(d.inst)&&feeds[d.inst]==uses[res->index]){
+			//a multiplication only feeding reduced additions dies instead
+			bool out=false;
+			for(int t=0;!out&&t<targets.size();t++)
+				out=live->getIn(targets[t]).get(res->index);
+			if(!out){
+				rewritten.insert(d.inst);
+				continue;
+			}
+		}
+		int f=0;
+		while(f<fams.size()&&!(fams[f].iv==d.iv&&fams[f].k==d.k&&fams[f].base==d.base))f++;
+		if(f==fams.size()){
+			Family fam={d.iv,d.k,d.base,new Var(res->getPath(),res)};
+			tab->AddTemp(fam.var);
+			plan.temps.push_back(fam.var);
+			fams.push_back(fam);
+		}
+		copies.push_back(make_pair(d.inst,f));
+		rewritten.insert(d.inst);
+		if(d.base)adds++;
+		else muls++;
+	}
+	#undef IV
+	if(fams.empty())return false;
+	//preheader: initial values
+	vector<InterInst*>&init=plan.before[lb];
+	unordered_set<Var*>reduced;
+	for(int f=0;f<fams.size();f++){
+		Family&fam=fams[f];
+		if(fam.k==1)init.push_back(new InterInst(OP_ADD,fam.var,fam.base,fam.iv));
+		else{
+			init.push_back(new InterInst(OP_MUL,fam.var,fam.iv,literal(fam.k)));
+			if(fam.base)init.push_back(new InterInst(OP_ADD,fam.var,fam.base,fam.var));
+		}
+		int inc=step[fam.iv->index]*fam.k;
+		InterInst*up=inc>0?new InterInst(OP_ADD,fam.var,fam.var,literal(inc))
+			:new InterInst(OP_SUB,fam.var,fam.var,literal(-inc));
+		plan.after[defOf[fam.iv->index]].push_back(up);
+		reduced.insert(fam.iv);
+	}
+	ivs+=reduced.size();
+	for(int i=0;i<copies.size();i++){
+		InterInst*inst=copies[i].first;
+		Edit e={inst,OP_AS,inst->getResult(),fams[copies[i].second].var,NULL};
+		plan.edits.push_back(e);
+	}
+	//linear function test replacement
+	for(int bi=0;bi<loop->blocks.size();bi++){
+		Block*e=loop->blocks[bi];
+		InterInst*jc=e->insts.back();
+		if(e->loop!=loop||!jc->isJcond())continue;
+		//the test i<n: t=i<n and if(!t), or the fused if(i>=n)
+		InterInst*cmp=NULL;
+		Var*cond=NULL;
+		Operator op=OP_NOP;//comparison made by the jump
+		bool onTrue=true;//the jump is taken when it holds
+		if(jc->getOp()>=OP_JG&&jc->getOp()<=OP_JLE){
+			cmp=jc;
+			op=(Operator)(OP_GT+jc->getOp()-OP_JG);//JG..JLE follow GT..LE
+		}
+		else if(jc->getOp()==OP_JT||jc->getOp()==OP_JF){
+			cond=jc->getArg1();
+			if(VarIndex::tracked(cond)&&defs[cond->index]==1&&defOf[cond->index]->block==e){
+				cmp=defOf[cond->index];
+				op=cmp->getOp();
+				onTrue=jc->getOp()==OP_JT;
+			}
+		}
+		if(!cmp)continue;
+		Var*iv=cmp->getArg1(),*bound=cmp->getArg2();
+		if(op<OP_GT||op>OP_LE||!reduced.count(iv)||bound->notConst())continue;
+		int c0=step[iv->index];
+		bool up=op==OP_LT||op==OP_LE;
+		if(up!=(c0>0)){//jumping when i>=n is jumping unless i<n
+			up=!up;
+			onTrue=!onTrue;
+		}
+		//leaves the loop exactly when the test fails
+		Block*to=jc->getTarget()->block;
+		Block*fall=e->id+1<all.size()?all[e->id+1]:NULL;
+		if(!fall)continue;
+		bool leaves=!onTrue?!loop->contains(to)&&loop->contains(fall)
+			:loop->contains(to)&&!loop->contains(fall);
+		if(!leaves)continue;
+		//tested every iteration
+		bool every=true;
+		for(int i=0;every&&i<loop->latches.size();i++)
+			every=dfg->dominates(e,loop->latches[i]);
+		if(!every)continue;
+		//no other use of i in the loop nor after it
+		InterInst*ivDef=defOf[iv->index];
+		bool used=false;
+		for(int i=0;!used&&i<loop->blocks.size();i++){
+			Block*b=loop->blocks[i];
+			for(int j=0;!used&&j<b->insts.size();j++){
+				InterInst*inst=b->insts[j];
+				if(inst->isLb()||inst==ivDef||inst==cmp||rewritten.count(inst))continue;
+				Var*read[2];
+				int n=inst->getUses(read);
+				for(int u=0;u<n;u++)
+					if(read[u]==iv)used=true;
+			}
+		}
+		for(int t=0;!used&&t<targets.size();t++)
+			used=live->getIn(targets[t]).get(iv->index);
+		if(used)continue;
+		//i stays between its entry value and the bound, s=i*k cannot overflow
+		Block*entry=NULL;
+		int outside=0,i0;
+		for(int i=0;i<h->prevs.size();i++)
+			if(!loop->contains(h->prevs[i])){entry=h->prevs[i];outside++;}
+		if(outside!=1||!entryValue(entry,iv,i0))continue;
+		//an int value, else an address in a global array: both stay positive
+		//and compare like i as long as the range is small enough
+		Family*fam=NULL;
+		for(int f=0;f<fams.size();f++){
+			if(fams[f].iv!=iv||fams[f].k<0)continue;
+			if(!fams[f].base){fam=&fams[f];break;}
+			if(!fam&&fams[f].base->getArray()&&fams[f].base->getPath().size()==1)fam=&fams[f];
+		}
+		if(!fam)continue;
+		long long n=bound->getVal();
+		long long span=max(llabs(i0),llabs(n)+llabs(c0))*fam->k;
+		if(span>=(fam->base?0x04000000LL:0x7fffffffLL))continue;
+		Var*limit=literal(n*fam->k);
+		if(fam->base){
+			limit=new Var(fam->var->getPath(),fam->var);
+			tab->AddTemp(limit);
+			plan.temps.push_back(limit);
+			init.push_back(new InterInst(OP_ADD,limit,fam->base,literal(n*fam->k)));
+		}
+		Edit test={cmp,cmp->getOp(),cond,fam->var,limit};
+		plan.edits.push_back(test);
+		ivDef->isDead=true;//only feeds itself now
+		tests++;
+	}
+	//redirect the jumps entering the loop
+	InterInst*pre=new InterInst();
+	plan.pres[lb]=pre;
+	for(int i=0;i<h->prevs.size();i++){
+		Block*p=h->prevs[i];
+		if(loop->contains(p))continue;
+		p->insts.back()->replaceTarget(lb,pre);
+	}
+	return true;
+}
+
+/*
+	执行强度削弱：one round over all loops. The values a loop reduces
+	belong to its own induction variables, which have no definition in
+	the other loops, so nested loops do not disturb each other. The
+	rewrites wait until every loop has been seen.
+*/
+void InductionVar::reduce()
+{
+	InterCode&code=fun->getInterCode();
+	Plan plan;
+	{
+		DFG dfg(code);
+		vector<Loop*>&loops=dfg.getLoops();
+		if(!loops.empty()){
+			LiveVar live(&dfg,code.getCode());
+			int n=live.getVars().size();
+			defs.assign(n,0);
+			uses.assign(n,0);
+			step.assign(n,0);
+			defOf.assign(n,NULL);
+			seen.clear();
+			for(int i=0;i<loops.size();i++)
+				reduce(&dfg,&live,loops[i],plan);
+		}
+	}
+	if(!plan.pres.empty()){
+		for(int i=0;i<plan.edits.size();i++){
+			Edit&e=plan.edits[i];
+			if(e.inst->isJcond())e.inst->replace(e.op,e.inst->getTarget(),e.arg1,e.arg2);
+			else e.inst->replace(e.op,e.res,e.arg1,e.arg2);
+		}
+		vector<InterInst*>&insts=code.getCode();
+		vector<InterInst*>out;
+		out.reserve(insts.size()*2);
+		for(int i=0;i<insts.size();i++){
+			InterInst*inst=insts[i];
+			if(plan.pres.count(inst)){
+				out.push_back(plan.pres[inst]);
+				vector<InterInst*>&init=plan.before[inst];
+				out.insert(out.end(),init.begin(),init.end());
+			}
+			out.push_back(inst);
+			if(i==0){
+				for(int t=0;t<plan.temps.size();t++)
+					out.push_back(new InterInst(OP_DEC,plan.temps[t]));
+			}
+			unordered_map<InterInst*,vector<InterInst*> >::iterator it=plan.after.find(inst);
+			if(it!=plan.after.end())
+				out.insert(out.end(),it->second.begin(),it->second.end());
+		}
+		insts.swap(out);
+		code.removeDead();
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: strength reduction %d induction variables, %d multiplications, %d address additions, %d exit tests replaced\n",
+			fun->getName().c_str(),ivs,muls,adds,tests);
+}
+
+/*
+	Instructions rewritten
+*/
+int InductionVar::getReduced()
+{
+	return muls+adds+tests;
+}
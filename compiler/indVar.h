@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+class Fun;
+class SymTab;
+class InterInst;
+class Var;
+class Block;
+class Loop;
+class DFG;
+class LiveVar;
+
+/*
+	Induction variable strength reduction.
+	A basic induction variable is an int with one definition in the loop,
+	i=i+c or i=i-c with a literal c. Its derived values i*k (k literal) and
+	a+i*k (a invariant, the address arithmetic of GenArray) get a variable
+	of their own, set in the preheader and bumped by c*k right after the
+	definition of i, so the loop no longer multiplies.
+	A multiplication whose only readers are reduced additions is left to
+	dead code elimination.
+	Linear function test replacement then rewrites the exit test i<n into
+	s<n*k, or p<a+n*k for an address in a global array, when the test and
+	the derived values are the only uses of i and the range of i is known;
+	the update of i is dropped.
+*/
+class InductionVar
+{
+	Fun*fun;
+	SymTab*tab;
+	int ivs;//basic induction variables reduced
+	int muls;//multiplications replaced
+	int adds;//address additions replaced
+	int tests;//exit tests replaced
+
+	//value i*k or base+i*k kept in a variable of its own
+	struct Family
+	{
+		Var*iv;//basic induction variable
+		int k;//factor
+		Var*base;//invariant array or pointer, NULL for i*k
+		Var*var;//variable holding the value
+	};
+
+	//instruction rewrite
+	struct Edit
+	{
+		InterInst*inst;
+		Operator op;
+		Var*res,*arg1,*arg2;
+	};
+
+	//changes of one round
+	struct Plan
+	{
+		vector<Edit>edits;//rewritten instructions
+		vector<Var*>temps;//new variables, declared after the entry
+		unordered_map<InterInst*,InterInst*>pres;//loop label -> preheader label
+		unordered_map<InterInst*,vector<InterInst*> >before;//loop label -> preheader code
+		unordered_map<InterInst*,vector<InterInst*> >after;//definition of i -> updates
+	};
+
+	unordered_map<int,Var*>literals;//literal cache
+	//per loop facts by Var::index, only the entries in seen are reset
+	vector<int>defs;//definitions in the loop
+	vector<int>uses;//reads in the loop
+	vector<int>step;//step of a basic induction variable, 0 for others
+	vector<InterInst*>defOf;//a definition in the loop
+	vector<int>seen;//indices referenced by the last loop
+
+	Var* literal(int val);//literal variable
+	bool entryValue(Block*b,Var*v,int&val);//literal value of v entering through b
+	bool reduce(DFG*dfg,LiveVar*live,Loop*loop,Plan&plan);//reduce one loop
+public:
+	InductionVar(Fun*fun,SymTab*tab);
+
+	void reduce();//执行强度削弱
+	int getReduced();//instructions rewritten
+};
@@ -0,0 +1,331 @@
+#include "inliner.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include "dfg.h"
+#include <unordered_set>
+#include <algorithm>
+
+/*******************************************************************************
+                                   调用图
+*******************************************************************************/
+
+/*
+	Global variable, named in every function by the same Var
+*/
+static bool isGlobal(Var*var)
+{
+	return var&&var->notConst()&&!var->isVoid()&&var->getPath().size()==1;
+}
+
+/*
+	Add the variables of from missing in to
+*/
+static void merge(vector<Var*>&to,unordered_set<Var*>&in,vector<Var*>&from)
+{
+	for(int i=0;i<from.size();i++)
+		if(in.insert(from[i]).second)to.push_back(from[i]);
+}
+
+/*
+	Record a finished function: its callees, size, whether its code can
+	be copied into another frame and the summary of its side effects.
+	A call to a function not finished yet, itself included, may do
+	anything and may not return.
+*/
+void CallGraph::add(Fun*fun)
+{
+	Node&node=nodes[fun];
+	node.callees.clear();
+	node.size=0;
+	node.cloneable=true;
+	bool stores=false,constRet=true,returns=false;
+	int retVal=0;
+	vector<Var*>reads,writes;
+	unordered_set<Var*>read,written;
+	DFG dfg(fun->getInterCode());
+	bool halts=dfg.getLoops().empty();//a loop may run forever
+	vector<InterInst*>&code=fun->getCode();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())continue;
+		Operator op=inst->getOp();
+		if(op==OP_CALL||op==OP_PROC){
+			Fun*callee=inst->getFun();
+			if(find(node.callees.begin(),node.callees.end(),callee)==node.callees.end())
+				node.callees.push_back(callee);
+			if(!callee->knownEffects())stores=true;
+			if(!callee->terminates())halts=false;
+			merge(reads,read,callee->getReads());
+			merge(writes,written,callee->getWrites());
+		}
+		if(op==OP_SET)stores=true;
+		if(op==OP_RETV){
+			Var*v=inst->getArg1();
+			if(!v->isLiteral())constRet=false;
+			else if(!returns||v->getVal()==retVal)retVal=v->getVal();
+			else constRet=false;
+			returns=true;
+		}
+		Var*def=inst->getDef();
+		if(isGlobal(def)&&written.insert(def).second)writes.push_back(def);
+		Var*uses[2];
+		int n=inst->getUses(uses);
+		for(int k=0;k<n;k++)
+			if(isGlobal(uses[k])&&read.insert(uses[k]).second)reads.push_back(uses[k]);
+		if(op==OP_DEC){
+			Var*var=inst->getArg1();
+			if(var->getArray()||!var->unInit()&&!var->isBase())node.cloneable=false;
+			continue;
+		}
+		if(op!=OP_ENTRY&&op!=OP_EXIT)node.size++;
+	}
+	fun->summarize(stores,halts,reads,writes,constRet&&returns,retVal);
+	if(Args::stats)
+		fprintf(stderr,"%s: %s%s, reads %d globals, writes %d globals%s\n",fun->getName().c_str(),
+			fun->isPure()?"pure":stores?"writes memory":"writes globals only",halts?"":", may not return",
+			(int)reads.size(),(int)writes.size(),
+			constRet&&returns?(", returns "+to_string(retVal)).c_str():"");
+}
+
+/*
+	fun is finished
+*/
+bool CallGraph::has(Fun*fun)
+{
+	return nodes.count(fun)>0;
+}
+
+/*
+	fun can reach itself through finished functions
+*/
+bool CallGraph::recursive(Fun*fun)
+{
+	unordered_set<Fun*>seen;
+	vector<Fun*>work(1,fun);
+	while(!work.empty()){
+		Fun*f=work.back();
+		work.pop_back();
+		unordered_map<Fun*,Node>::iterator it=nodes.find(f);
+		if(it==nodes.end())continue;
+		vector<Fun*>&callees=it->second.callees;
+		for(int i=0;i<callees.size();i++){
+			if(callees[i]==fun)return true;
+			if(seen.insert(callees[i]).second)work.push_back(callees[i]);
+		}
+	}
+	return false;
+}
+
+/*
+	fun calls nothing
+*/
+bool CallGraph::isLeaf(Fun*fun)
+{
+	return nodes[fun].callees.empty();
+}
+
+/*
+	The code of fun can be copied
+*/
+bool CallGraph::cloneable(Fun*fun)
+{
+	return nodes[fun].cloneable;
+}
+
+/*
+	Instructions of fun
+*/
+int CallGraph::getSize(Fun*fun)
+{
+	return nodes[fun].size;
+}
+
+/*
+	Small enough to be inlined at some call with the most favourable
+	arguments. Streaming keeps the code of such functions.
+*/
+bool CallGraph::keep(Fun*fun)
+{
+	if(!has(fun)||!cloneable(fun))return false;
+	int n=fun->getParaVar().size();
+	return getSize(fun)<=INLINE_SIZE+INLINE_LEAF+(INLINE_ARG+INLINE_LITERAL)*n;
+}
+
+/*******************************************************************************
+                                   内联
+*******************************************************************************/
+
+Inliner::Inliner(Fun*fun,SymTab*tab,CallGraph*graph):fun(fun),tab(tab),graph(graph),calls(0),insts(0)
+{
+}
+
+/*
+	Literal variable
+*/
+Var* Inliner::literal(int val)
+{
+	unordered_map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	Size/benefit heuristic: the callee may be as large as the overhead of
+	the call plus what literal arguments and a leaf body may save
+*/
+bool Inliner::worth(Fun*callee,int literalArgs,int budget)
+{
+	if(callee==fun||callee->getExtern()||!graph->has(callee))return false;
+	if(!graph->cloneable(callee)||graph->recursive(callee))return false;
+	int limit=INLINE_SIZE+INLINE_ARG*callee->getParaVar().size()+INLINE_LITERAL*literalArgs;
+	if(graph->isLeaf(callee))limit+=INLINE_LEAF;
+	int size=graph->getSize(callee);
+	return size<=limit&&size<=budget;
+}
+
+/*
+	Caller temporary standing for a callee variable, literals and globals
+	are shared
+*/
+Var* Inliner::clone(Var*v,unordered_map<Var*,Var*>&vars,vector<Var*>&temps)
+{
+	if(!v||!v->notConst()||v->isVoid()||v->getPath().size()==1)return v;
+	unordered_map<Var*,Var*>::iterator it=vars.find(v);
+	if(it!=vars.end())return it->second;
+	Var*c=new Var(v->getPath(),v);
+	c->inMem=v->inMem;
+	tab->AddTemp(c);
+	temps.push_back(c);
+	vars[v]=c;
+	return c;
+}
+
+/*
+	Copy the callee's body in place of the call. Entry and exit go away,
+	a return copies its value to the call's result and jumps to the clone
+	of the return point, which the callee places right before its exit.
+*/
+void Inliner::copyBody(Fun*callee,InterInst*call,unordered_map<Var*,Var*>&vars,
+	vector<Var*>&temps,vector<InterInst*>&out)
+{
+	vector<InterInst*>&body=callee->getCode();
+	unordered_map<InterInst*,InterInst*>labels;
+	for(int i=0;i<body.size();i++)
+		if(body[i]->isLb())labels[body[i]]=new InterInst();
+	for(int i=0;i<body.size();i++){
+		InterInst*inst=body[i];
+		if(inst->isLb()){
+			out.push_back(labels[inst]);
+			continue;
+		}
+		Operator op=inst->getOp();
+		Var*res=clone(inst->getResult(),vars,temps);
+		Var*arg1=clone(inst->getArg1(),vars,temps);
+		Var*arg2=clone(inst->getArg2(),vars,temps);
+		switch(op){
+			case OP_ENTRY:case OP_EXIT:break;
+			case OP_DEC:
+				if(!inst->getArg1()->unInit())//declared at the caller's entry, initialised here
+					out.push_back(new InterInst(OP_AS,arg1,literal(inst->getArg1()->getVal())));
+				break;
+			case OP_RETV:
+				if(call->getOp()==OP_CALL)
+					out.push_back(new InterInst(OP_AS,call->getResult(),arg1));
+				// fallthrough
+			case OP_RET:
+				out.push_back(new InterInst(OP_JMP,labels[inst->getTarget()]));
+				break;
+			case OP_CALL:
+				out.push_back(new InterInst(OP_CALL,inst->getFun(),res));
+				break;
+			case OP_PROC:
+				out.push_back(new InterInst(OP_PROC,inst->getFun()));
+				break;
+			case OP_JTAB:
+			{
+				vector<InterInst*>table=inst->getTable();
+				for(int k=0;k<table.size();k++)table[k]=labels[table[k]];
+				out.push_back(new InterInst(op,labels[inst->getTarget()],table,arg1,arg2));
+				break;
+			}
+			default:
+				if(op==OP_JMP||inst->isJcond())
+					out.push_back(new InterInst(op,labels[inst->getTarget()],arg1,arg2));
+				else
+					out.push_back(new InterInst(op,res,arg1,arg2));
+		}
+		if(op!=OP_ENTRY&&op!=OP_EXIT&&op!=OP_DEC)insts++;
+	}
+}
+
+/*
+	执行内联：find the calls worth expanding and their pushes, the pushes
+	of a call are the last ones before it
+*/
+void Inliner::expand()
+{
+	vector<InterInst*>&code=fun->getCode();
+	int budget=0;
+	for(int i=0;i<code.size();i++)
+		if(!code[i]->isLb()&&code[i]->getOp()!=OP_DEC)budget++;
+	budget=max(budget,INLINE_GROWTH);
+	//call sites
+	unordered_map<InterInst*,unordered_map<Var*,Var*> >sites;//call -> callee variables
+	unordered_map<InterInst*,Var*>params;//push -> parameter clone
+	vector<Var*>temps;
+	for(int i=0;i<code.size();i++){
+		InterInst*call=code[i];
+		if(call->isLb()||call->getOp()!=OP_CALL&&call->getOp()!=OP_PROC)continue;
+		Fun*callee=call->getFun();
+		vector<Var*>&paras=callee->getParaVar();
+		vector<InterInst*>args;
+		for(int j=i-1;j>0&&args.size()<paras.size();j--){
+			InterInst*inst=code[j];
+			if(inst->isLb()||inst->isJmp()||inst->isJcond()||
+				inst->getOp()==OP_CALL||inst->getOp()==OP_PROC)break;
+			if(inst->getOp()==OP_ARG)args.push_back(inst);
+		}
+		if(args.size()!=paras.size())continue;
+		int lits=0;
+		for(int k=0;k<args.size();k++)
+			if(!args[k]->getArg1()->notConst())lits++;
+		if(!worth(callee,lits,budget))continue;
+		budget-=graph->getSize(callee);
+		unordered_map<Var*,Var*>&vars=sites[call];
+		for(int k=0;k<args.size();k++)//the last push is the first parameter
+			params[args[k]]=clone(paras[k],vars,temps);
+		calls++;
+	}
+	if(!sites.empty()){
+		//rewrite: pushes become copies, calls become bodies
+		vector<InterInst*>out;
+		out.reserve(code.size()+temps.size()+INLINE_GROWTH);
+		for(int i=0;i<code.size();i++){
+			InterInst*inst=code[i];
+			unordered_map<InterInst*,Var*>::iterator p=params.find(inst);
+			unordered_map<InterInst*,unordered_map<Var*,Var*> >::iterator s=sites.find(inst);
+			if(p!=params.end()){
+				out.push_back(new InterInst(OP_AS,p->second,inst->getArg1()));
+				delete inst;
+			}
+			else if(s!=sites.end()){
+				copyBody(inst->getFun(),inst,s->second,temps,out);
+				delete inst;
+			}
+			else out.push_back(inst);
+		}
+		//declarations of the temporaries after the entry
+		vector<InterInst*>decs;
+		for(int t=0;t<temps.size();t++)
+			decs.push_back(new InterInst(OP_DEC,temps[t]));
+		out.insert(out.begin()+1,decs.begin(),decs.end());
+		code.swap(out);
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: inlined %d calls, %d instructions\n",fun->getName().c_str(),calls,insts);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+class Fun;
+class SymTab;
+class InterInst;
+class Var;
+
+#define INLINE_SIZE 12//instructions a callee may have
+#define INLINE_ARG 2//more per parameter, its push goes away
+#define INLINE_LITERAL 3//more per literal argument, it may fold
+#define INLINE_LEAF 8//more for a callee that calls nothing
+#define INLINE_GROWTH 400//instructions a caller may gain, or its own size if larger
+
+/*
+	Call graph over the functions of SymTab's funList, a function joins it
+	once its definition is finished and optimized. Joining also gives the
+	function its summary: the globals it and its callees read and write,
+	whether it may store through a pointer or call an unknown function,
+	and the literal it always returns if any.
+*/
+class CallGraph
+{
+	struct Node
+	{
+		vector<Fun*>callees;//functions called, each once
+		int size;//instructions besides labels, declarations, entry and exit
+		bool cloneable;//no local array nor pointer initialised by a string
+	};
+	unordered_map<Fun*,Node>nodes;
+public:
+	void add(Fun*fun);//record a finished function
+	bool has(Fun*fun);//fun is finished
+	bool recursive(Fun*fun);//fun can reach itself
+	bool isLeaf(Fun*fun);//fun calls nothing
+	bool cloneable(Fun*fun);//the code of fun can be copied
+	int getSize(Fun*fun);//instructions of fun
+	bool keep(Fun*fun);//small enough to be inlined at some call
+};
+
+/*
+	Inliner of small and leaf functions.
+	A call is expanded when the callee is finished, not recursive and its
+	size is within a limit that grows with the work the call costs or may
+	save: pushes, the frame, literal arguments and calls inside a leaf.
+	Every local, temporary and parameter of the callee gets a temporary of
+	the caller, which the frame layout places, labels are cloned, the
+	pushes become copies to the parameters and returns jump to the clone
+	of the return point after copying the value to the call's result.
+*/
+class Inliner
+{
+	Fun*fun;
+	SymTab*tab;
+	CallGraph*graph;
+	int calls;//calls expanded
+	int insts;//instructions added
+	unordered_map<int,Var*>literals;//literal cache
+
+	Var* literal(int val);//literal variable
+	bool worth(Fun*callee,int literalArgs,int budget);//size/benefit heuristic
+	Var* clone(Var*v,unordered_map<Var*,Var*>&vars,vector<Var*>&temps);//caller temporary standing for a callee variable
+	void copyBody(Fun*callee,InterInst*call,unordered_map<Var*,Var*>&vars,
+		vector<Var*>&temps,vector<InterInst*>&out);//copy the callee's body
+public:
+	Inliner(Fun*fun,SymTab*tab,CallGraph*graph);
+
+	void expand();//执行内联
+};
@@ -1,6 +1,7 @@
 #include "interCode.h"
 #include "symbol.h"
 #include "genIr.h"
+#include "regAlloc.h"
 //#include "platform.h"
 
 /*******************************************************************************
@@ -19,6 +20,8 @@ void InterInst::init()
 	this->fun=NULL;
 	this->arg2=NULL;
 	first=false;
+	tail=false;
+	block=NULL;
 	isDead=false;
 }
 
@@ -79,6 +82,19 @@ InterInst::InterInst (Operator op,InterInst *tar,Var *arg1,Var *arg2)
 	this->arg2=arg2;
 }
 
+/*
+	跳转表指令
+*/
+InterInst::InterInst (Operator op,InterInst *tar,vector<InterInst*>&table,Var *arg1,Var *arg2)
+{
+	init();
+	this->op=op;
+	this->target=tar;
+	this->table=table;
+	this->arg1=arg1;
+	this->arg2=arg2;
+}
+
 /*
 	替换表达式指令信息
 */
@@ -91,10 +107,11 @@ void InterInst::replace(Operator op,Var *rs,Var *arg1,Var *arg2)
 }
 
 /*
-	替换跳转指令信息，条件跳转优化
+	替换跳转指令信息，条件跳转优化，只有JTAB保留跳转表
 */
 void InterInst::replace(Operator op,InterInst *tar,Var *arg1,Var *arg2)
 {
+	if(op!=OP_JTAB)table.clear();
 	this->op=op;
 	this->target=tar;
 	this->arg1=arg1;
@@ -142,6 +159,12 @@ void InterInst::toString()
 		case OP_DIV:result->value();printf(" = ");arg1->value();printf(" / ");arg2->value();break;
 		case OP_MOD:result->value();printf(" = ");arg1->value();printf(" %% ");arg2->value();break;
 		case OP_NEG:result->value();printf(" = ");printf("-");arg1->value();break;
+		case OP_SHL:result->value();printf(" = ");arg1->value();printf(" << ");arg2->value();break;
+		case OP_SAR:result->value();printf(" = ");arg1->value();printf(" >> ");arg2->value();break;
+		case OP_SHR:result->value();printf(" = ");arg1->value();printf(" >>> ");arg2->value();break;
+		case OP_BAND:result->value();printf(" = ");arg1->value();printf(" & ");arg2->value();break;
+		case OP_BOR:result->value();printf(" = ");arg1->value();printf(" | ");arg2->value();break;
+		case OP_BXOR:result->value();printf(" = ");arg1->value();printf(" ^ ");arg2->value();break;
 		case OP_GT:result->value();printf(" = ");arg1->value();printf(" > ");arg2->value();break;
 		case OP_GE:result->value();printf(" = ");arg1->value();printf(" >= ");arg2->value();break;
 		case OP_LT:result->value();printf(" = ");arg1->value();printf(" < ");arg2->value();break;
@@ -154,21 +177,22 @@ void InterInst::toString()
 		case OP_JMP:printf("goto %s",target->label.c_str());break;
 		case OP_JT:printf("if( ");arg1->value();printf(" )goto %s",target->label.c_str());break;
 		case OP_JF:printf("if( !");arg1->value();printf(" )goto %s",target->label.c_str());break;
-		// case OP_JG:printf("if( ");arg1->value();printf(" > ");arg2->value();printf(" )goto %s",
-		// 	target->label.c_str());break;
-		// case OP_JGE:printf("if( ");arg1->value();printf(" >= ");arg2->value();printf(" )goto %s",
-		// 	target->label.c_str());break;
-		// case OP_JL:printf("if( ");arg1->value();printf(" < ");arg2->value();printf(" )goto %s",
-		// 	target->label.c_str());break;
-		// case OP_JLE:printf("if( ");arg1->value();printf(" <= ");arg2->value();printf(" )goto %s",
-		// 	target->label.c_str());break;
-		// case OP_JE:printf("if( ");arg1->value();printf(" == ");arg2->value();printf(" )goto %s",
-		// 	target->label.c_str());break;
+		case OP_JG:printf("if( ");arg1->value();printf(" > ");arg2->value();printf(" )goto %s",
+			target->label.c_str());break;
+		case OP_JGE:printf("if( ");arg1->value();printf(" >= ");arg2->value();printf(" )goto %s",
+			target->label.c_str());break;
+		case OP_JL:printf("if( ");arg1->value();printf(" < ");arg2->value();printf(" )goto %s",
+			target->label.c_str());break;
+		case OP_JLE:printf("if( ");arg1->value();printf(" <= ");arg2->value();printf(" )goto %s",
+			target->label.c_str());break;
+		case OP_JE:printf("if( ");arg1->value();printf(" == ");arg2->value();printf(" )goto %s",
+			target->label.c_str());break;
 		case OP_JNE:printf("if( ");arg1->value();printf(" != ");arg2->value();printf(" )goto %s",
 			target->label.c_str());break;
+		case OP_JTAB:printf("%s",InstToStr().c_str());return;
 		case OP_ARG:printf("arg ");arg1->value();break;
-		case OP_PROC:printf("%s()",fun->getName().c_str());break;
-		case OP_CALL:result->value();printf(" = %s()",fun->getName().c_str());break;
+		case OP_PROC:printf("%s%s()",tail?"tail ":"",fun->getName().c_str());break;
+		case OP_CALL:result->value();printf(" = %s%s()",tail?"tail ":"",fun->getName().c_str());break;
 		case OP_RET:printf("return goto %s",target->label.c_str());break;
 		case OP_RETV:printf("return ");arg1->value();printf(" goto %s",target->label.c_str());break;
 		case OP_LEA:result->value();printf(" = ");printf("&");arg1->value();break;
@@ -181,7 +205,7 @@ void InterInst::toString()
 string InterInst::InstToStr()
 {
 	if(label!=""){
-		return label;
+		return label + ":\n";
 	}
 	switch(op)
 	{
@@ -194,8 +218,14 @@ string InterInst::InstToStr()
 		case OP_SUB:return result->valueStr() + " = " + arg1->valueStr() + " - " + arg2->valueStr() + "\n";
 		case OP_MUL: return result->valueStr() + " = " + arg1->valueStr() + " * " + arg2->valueStr() + "\n";
 		case OP_DIV: return result->valueStr() + " = " + arg1->valueStr() + " / " + arg2->valueStr() + "\n";
-		case OP_MOD: return result->valueStr() + " = " + arg1->valueStr() + " %% " + arg2->valueStr() + "\n";
+		case OP_MOD: return result->valueStr() + " = " + arg1->valueStr() + " % " + arg2->valueStr() + "\n";
 		case OP_NEG: return result->valueStr() + " = " + "-" + arg1->valueStr() + "\n";
+		case OP_SHL: return result->valueStr() + " = " + arg1->valueStr() + " << " + arg2->valueStr() + "\n";
+		case OP_SAR: return result->valueStr() + " = " + arg1->valueStr() + " >> " + arg2->valueStr() + "\n";
+		case OP_SHR: return result->valueStr() + " = " + arg1->valueStr() + " >>> " + arg2->valueStr() + "\n";
+		case OP_BAND: return result->valueStr() + " = " + arg1->valueStr() + " & " + arg2->valueStr() + "\n";
+		case OP_BOR: return result->valueStr() + " = " + arg1->valueStr() + " | " + arg2->valueStr() + "\n";
+		case OP_BXOR: return result->valueStr() + " = " + arg1->valueStr() + " ^ " + arg2->valueStr() + "\n";
 		case OP_GT: return result->valueStr() + " = " + arg1->valueStr() + " > " + arg2->valueStr() + "\n";
 		case OP_GE: return result->valueStr() + " = " + arg1->valueStr() + " >= " + arg2->valueStr() + "\n";
 		case OP_LT: return result->valueStr() + " = " + arg1->valueStr() + " < " + arg2->valueStr() + "\n";
@@ -208,26 +238,29 @@ string InterInst::InstToStr()
 		case OP_JMP: return "goto " + target->label + "\n";
 		case OP_JT: return "if( " + arg1->valueStr() + " )goto " + target->label + "\n";
 		case OP_JF: return "if( !" + arg1->valueStr() + " )goto " + target->label + "\n";
-		// case OP_JG: return "if( " + arg1->valueStr() + " > " + arg2->valueStr() + " )goto %s",
-		// 	target->label.c_str()) + "\n";
-		// case OP_JGE: return "if( " + arg1->valueStr() + " >= " + arg2->valueStr() + " )goto %s",
-		// 	target->label.c_str()) + "\n";
-		// case OP_JL: return "if( " + arg1->valueStr() + " < " + arg2->valueStr() + " )goto %s",
-		// 	target->label.c_str()) + "\n";
-		// case OP_JLE: return "if( " + arg1->valueStr() + " <= " + arg2->valueStr() + " )goto %s",
-		// 	target->label.c_str()) + "\n";
-		// case OP_JE: return "if( " + arg1->valueStr() + " == " + arg2->valueStr() + " )goto %s",
-		// 	target->label.c_str()) + "\n";
+		case OP_JG: return "if( " + arg1->valueStr() + " > " + arg2->valueStr() + " )goto " + target->label + "\n";
+		case OP_JGE: return "if( " + arg1->valueStr() + " >= " + arg2->valueStr() + " )goto " + target->label + "\n";
+		case OP_JL: return "if( " + arg1->valueStr() + " < " + arg2->valueStr() + " )goto " + target->label + "\n";
+		case OP_JLE: return "if( " + arg1->valueStr() + " <= " + arg2->valueStr() + " )goto " + target->label + "\n";
+		case OP_JE: return "if( " + arg1->valueStr() + " == " + arg2->valueStr() + " )goto " + target->label + "\n";
 		case OP_JNE: return "if( " + arg1->valueStr() + " != " + arg2->valueStr() + " )goto " + target->label + "\n";
+		case OP_JTAB:
+		{
+			string str = "goto [" + arg1->valueStr() + " - " + arg2->valueStr() + "] {";
+			for (int i = 0; i < table.size(); i++)
+				str += (i ? " " : "") + table[i]->label;
+			return str + "} else " + target->label + "\n";
+		}
 		case OP_ARG: return "arg " + arg1->valueStr() + "\n";
-		case OP_PROC: return fun->getName() + "()" + "\n";
-		case OP_CALL: return result->valueStr() + " = " + fun->getName() + "()" + "\n";
+		case OP_PROC: return (tail ? "tail " : "") + fun->getName() + "()" + "\n";
+		case OP_CALL: return result->valueStr() + " = " + (tail ? "tail " : "") + fun->getName() + "()" + "\n";
 		case OP_RET: return "return goto " + target->label + "\n";
-		case OP_RETV: return "return " + arg1->valueStr() + " goto ",target->label + "\n";
+		case OP_RETV: return "return " + arg1->valueStr() + " goto " + target->label + "\n";
 		case OP_LEA: return result->valueStr() + " = " + "&" + arg1->valueStr() + "\n";
 		case OP_SET: return "*" + arg1->valueStr() + " = " + result->valueStr() + "\n";
 		case OP_GET: return result->valueStr() + " = " + "*" + arg1->valueStr() + "\n";
 	}
+	return "";
 }
 /*
 	是否条件转移指令JT,JF,Jcond
@@ -238,11 +271,11 @@ bool InterInst::isJcond()
 }
 
 /*
-	是否直接转移指令JMP,return
+	是否直接转移指令JMP,return,JTAB
 */
 bool InterInst::isJmp()
 {
-	return op==OP_JMP||op==OP_RET||op==OP_RETV;
+	return op==OP_JMP||op==OP_RET||op==OP_RETV||op==OP_JTAB;
 }
 
 /*
@@ -253,6 +286,30 @@ void InterInst::setFirst()
 	first=true;
 }
 
+/*
+	Clear the leader mark
+*/
+void InterInst::clearFirst()
+{
+	first=false;
+}
+
+/*
+	Mark a call in tail position, it jumps to the callee in our frame
+*/
+void InterInst::setTail()
+{
+	tail=true;
+}
+
+/*
+	Call jumping in our frame
+*/
+bool InterInst::isTail()
+{
+	return tail;
+}
+
 /*
 	是首指令
 */
@@ -279,10 +336,108 @@ bool InterInst::isExpr()
 
 /*
 	不确定运算结果影响的运算(指针赋值，函数调用)
+	A call to a function whose summary is known writes only the globals of
+	getWrites, it is not unknown.
 */
 bool InterInst::unknown()
 {
-	return op==OP_SET||op==OP_PROC||op==OP_CALL;
+	if(op==OP_PROC||op==OP_CALL)return !getFun()->knownEffects();
+	return op==OP_SET;
+}
+
+/*
+	Globals written by a call with known effects, empty for the other
+	instructions
+*/
+vector<Var*>& InterInst::getWrites()
+{
+	static vector<Var*>none;
+	if(label==""&&(op==OP_PROC||op==OP_CALL)&&getFun()->knownEffects())return getFun()->getWrites();
+	return none;
+}
+
+/*
+	Variable written by the instruction, NULL if none.
+	An initialised declaration writes its initial value.
+*/
+Var* InterInst::getDef()
+{
+	if(label!="")return NULL;
+	if(isExpr()||op==OP_LEA||op==OP_CALL)return result;
+	if(op==OP_DEC&&!arg1->unInit())return arg1;
+	return NULL;
+}
+
+/*
+	Variables read by the instruction, literals included, returns the count.
+	&x counts as a use of x so that x keeps its storage.
+*/
+int InterInst::getUses(Var*uses[2])
+{
+	int n=0;
+	if(label!="")return 0;
+	switch(op)
+	{
+		case OP_SET:
+			uses[n++]=result;
+			uses[n++]=arg1;
+			break;
+		case OP_DEC:
+		case OP_ENTRY:
+		case OP_EXIT:
+		case OP_JMP:
+		case OP_RET:
+		case OP_PROC:
+		case OP_CALL:
+			break;
+		default:
+			if(arg1)uses[n++]=arg1;
+			if(arg2)uses[n++]=arg2;
+	}
+	return n;
+}
+
+/*
+	Read to instead of from, returns the number of operands changed.
+	The operand of &x names its storage rather than its value and stays.
+*/
+int InterInst::replaceUse(Var*from,Var*to)
+{
+	int n=0;
+	if(label!=""||op==OP_LEA)return 0;
+	switch(op)
+	{
+		case OP_SET:
+			if(result==from){result=to;n++;}
+			if(arg1==from){arg1=to;n++;}
+			break;
+		case OP_DEC:
+		case OP_ENTRY:
+		case OP_EXIT:
+		case OP_JMP:
+		case OP_RET:
+		case OP_PROC:
+		case OP_CALL:
+			break;
+		default:
+			if(arg1==from){arg1=to;n++;}
+			if(arg2==from){arg2=to;n++;}
+	}
+	return n;
+}
+
+/*
+	Jump to instead of from, returns the number of targets changed.
+	Returns are left alone, their target is the exit of the function.
+*/
+int InterInst::replaceTarget(InterInst*from,InterInst*to)
+{
+	int n=0;
+	if(label!=""||op!=OP_JMP&&op!=OP_JTAB&&!isJcond())return 0;
+	if(target==from){target=to;n++;}
+	for(int i=0;i<table.size();i++)
+		if(table[i]==from){table[i]=to;n++;}
+	return n;
 }
 
 /*
@@ -302,6 +457,23 @@ InterInst* InterInst::getTarget()
 	return target;
 }
 
+/*
+	获取跳转表
+*/
+vector<InterInst*>& InterInst::getTable()
+{
+	return table;
+}
+
+/*
+	Label a jump table goes to for val, its target outside the table
+*/
+InterInst* InterInst::caseOf(int val)
+{
+	unsigned k=(unsigned)val-(unsigned)arg2->getVal();
+	return k<table.size()?table[k]:target;
+}
+
 /*
 	获取返回值
 */
@@ -318,6 +490,14 @@ void InterInst::setArg1(Var*arg1)
 	this->arg1=arg1;
 }
 
+/*
+	Set the result
+*/
+void InterInst::setResult(Var*result)
+{
+	this->result=result;
+}
+
 
 
 /*
@@ -368,12 +548,22 @@ void InterInst::LoadVar(FILE* file, string reg32, string reg8, Var* pVar)
         return;
     }
 
+    if (pVar->regId >= 0)
+    {
+        const char* reg = RegAllocator::name(pVar->regId);
+        if (reg32 != reg)
+        {
+            emit("move %s, %s", reg32.c_str(), reg);
+        }
+        return;
+    }
     const char* reg = pVar->isChar() ? reg8.c_str() : reg32.c_str();
     if (pVar->isChar())
     {
         emit("move %s, 0", reg32.c_str());
     }
-    const char* name = pVar->getName().c_str();
+    string varName = pVar->getName();
+    const char* name = varName.c_str();
     if (pVar->notConst())
     {
         int off = pVar->getOffset();
@@ -421,8 +611,18 @@ void InterInst::StoreVar(FILE* file, string reg32, string reg8, Var* pVar)
         return;
     }
 
+    if (pVar->regId >= 0)
+    {
+        const char* reg = RegAllocator::name(pVar->regId);
+        if (reg32 != reg)
+        {
+            emit("move %s, %s", reg, reg32.c_str());
+        }
+        return;
+    }
     const char* reg = pVar->isChar() ? reg8.c_str() : reg32.c_str();
-    const char* name = pVar->getName().c_str();
+    string varName = pVar->getName();
+    const char* name = varName.c_str();
     int off = pVar->getOffset();
     if (!off)
     {
@@ -434,6 +634,27 @@ void InterInst::StoreVar(FILE* file, string reg32, string reg8, Var* pVar)
     }
 }
 
+// register of the operand, loaded into reg32 unless it already lives in one
+string InterInst::UseVar(FILE* file, string reg32, string reg8, Var* pVar)
+{
+    if (pVar->regId >= 0)
+    {
+        return RegAllocator::name(pVar->regId);
+    }
+    LoadVar(file, reg32, reg8, pVar);
+    return reg32;
+}
+
+// reload the callee saved registers of owner from the bottom of its frame
+void InterInst::RestoreRegs(FILE* file, Fun* owner)
+{
+    vector<int>& saved = owner->getSaved();
+    for (int i = 0; i < saved.size(); i++)
+    {
+        emit("move %s, [ebp%+d]", RegAllocator::name(saved[i]), 4 * i - owner->getMaxDep());
+    }
+}
+
 void InterInst::LeaVar(FILE* file, string reg32, Var* pVar)
 {
     if (!pVar)
@@ -442,7 +663,8 @@ void InterInst::LeaVar(FILE* file, string reg32, Var* pVar)
     }
 
     const char* reg = reg32.c_str();
-    const char* name = pVar->getName().c_str();
+    string varName = pVar->getName();
+    const char* name = varName.c_str();
     int off= pVar->getOffset();
 
     if (!off)
@@ -476,7 +698,8 @@ void InterInst::InitVar(FILE* file, Var* pVar)
     }
 }
 
-void InterInst::ToX86(FILE* file)
+// eax and edx are scratch, ecx too for divisors and shift counts
+void InterInst::ToX86(FILE* file, Fun* owner)
 {
     if (label != "")
     {
@@ -489,153 +712,204 @@ void InterInst::ToX86(FILE* file)
             InitVar(file, arg1);
             break;
         case OP_ENTRY:
+        {
             emit("push ebp");
             emit("move ebp, esp");
-            emit("sub esp, %d", getFun()->getMaxDep());
+            emit("sub esp, %d", fun->getMaxDep());
+            vector<int>& saved = fun->getSaved();
+            for (int i = 0; i < saved.size(); i++)
+            {
+                emit("move [ebp%+d], %s", 4 * i - fun->getMaxDep(), RegAllocator::name(saved[i]));
+            }
+            vector<Var*>& paras = fun->getParaVar();
+            for (int i = 0; i < paras.size(); i++)
+            {
+                if (paras[i]->regId >= 0)
+                    emit("move %s, [ebp%+d]", RegAllocator::name(paras[i]->regId), paras[i]->getOffset());
+            }
             break;
+        }
         case OP_EXIT:
+            RestoreRegs(file, fun);
             emit("move esp, ebp");
             emit("pop ebp");
             emit("ret");
             break;
         case OP_AS:
-            LoadVar(file, "eax", "al", arg1);
-            StoreVar(file, "eax", "al", result);
+            if (result->regId >= 0 && !arg1->isChar())
+            {
+                LoadVar(file, RegAllocator::name(result->regId), "", arg1);
+            }
+            else
+            {
+                LoadVar(file, "eax", "al", arg1);
+                StoreVar(file, "eax", "al", result);
+            }
             break;
         case OP_ADD:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("add eax, ebx");
-            StoreVar(file, "eax", "al", result);
-            break;
         case OP_SUB:
+        case OP_BAND:
+        case OP_BOR:
+        case OP_BXOR:
+        {
+            const char* alu = op == OP_ADD ? "add" : op == OP_SUB ? "sub" :
+                op == OP_BAND ? "and" : op == OP_BOR ? "or" : "xor";
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("sub eax, ebx");
+            string src = UseVar(file, "edx", "dl", arg2);
+            emit("%s eax, %s", alu, src.c_str());
             StoreVar(file, "eax", "al", result);
             break;
+        }
         case OP_MUL:
+        {
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("imul ebx");
+            string src = UseVar(file, "edx", "dl", arg2);
+            emit("imul %s", src.c_str());
             StoreVar(file, "eax", "al", result);
             break;
+        }
         case OP_DIV:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("idiv ebx");
-            StoreVar(file, "eax", "al", result);
-            break;
         case OP_MOD:
+        {
+            // cdq takes edx, the divisor goes to ecx
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("idiv ebx");
-            StoreVar(file, "edx", "al", result);
+            string src = UseVar(file, "ecx", "cl", arg2);
+            emit("cdq");
+            emit("idiv %s", src.c_str());
+            if (op == OP_DIV)
+                StoreVar(file, "eax", "al", result);
+            else
+                StoreVar(file, "edx", "dl", result);
             break;
+        }
         case OP_NEG:
             LoadVar(file, "eax", "al", arg1);
             emit("neg eax");
             StoreVar(file, "eax", "al", result);
             break;
-        case OP_GT:
+        case OP_SHL:
+        case OP_SAR:
+        case OP_SHR:
+        {
+            static const char* sh[] = {"shl", "sar", "shr"};
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("setg cl");
-            StoreVar(file, "ecx", "cl", result);
+            if (arg2->isLiteral())
+            {
+                emit("%s eax, %d", sh[op - OP_SHL], arg2->getVal() & 31);
+            }
+            else
+            {
+                LoadVar(file, "ecx", "cl", arg2);
+                emit("%s eax, cl", sh[op - OP_SHL]);
+            }
+            StoreVar(file, "eax", "al", result);
             break;
+        }
+        case OP_GT:
         case OP_GE:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("setge cl");
-            StoreVar(file, "ecx", "cl", result);
-            break;
         case OP_LT:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("setgl cl");
-            StoreVar(file, "ecx", "cl", result);
-            break;
         case OP_LE:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("setle cl");
-            StoreVar(file, "ecx", "cl", result);
-            break;
         case OP_EQU:
-            LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("sete cl");
-            StoreVar(file, "ecx", "cl", result);
-            break;
         case OP_NE:
+        {
+            static const char* setcc[] = {"setg", "setge", "setl", "setle", "sete", "setne"};
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("move ecx, 0");
-            emit("cmp eax, ebx");
-            emit("setne cl");
-            StoreVar(file, "ecx", "cl", result);
+            string src = UseVar(file, "edx", "dl", arg2);
+            emit("cmp eax, %s", src.c_str());
+            emit("move eax, 0");
+            emit("%s al", setcc[op - OP_GT]);
+            StoreVar(file, "eax", "al", result);
             break;
+        }
         case OP_NOT:
-            LoadVar(file, "eax", "al", arg1);
-            emit("move ebx, 0");
-            emit("cmp eax, 0");
-            emit("sete bl");
-            StoreVar(file, "ebx", "bl", result);
-            break;
-        case OP_AND:
-            LoadVar(file, "eax", "al", arg1);
-            emit("cmp eax, 0");
-            emit("setne cl");
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("cmp ebx, 0");
-            emit("setne bl");
-            emit("add eax, ebx");
+        {
+            string src = UseVar(file, "edx", "dl", arg1);
+            emit("move eax, 0");
+            emit("cmp %s, 0", src.c_str());
+            emit("sete al");
             StoreVar(file, "eax", "al", result);
             break;
+        }
+        case OP_AND:
         case OP_OR:
-            LoadVar(file, "eax", "al", arg1);
-            emit("cmp eax, 0");
-            emit("setne cl");
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("cmp ebx, 0");
-            emit("setne bl");
-            emit("or eax, ebx");
+        {
+            string src = UseVar(file, "edx", "dl", arg1);
+            emit("move eax, 0");
+            emit("cmp %s, 0", src.c_str());
+            emit("setne al");
+            src = UseVar(file, "edx", "dl", arg2);
+            emit("cmp %s, 0", src.c_str());
+            emit("move edx, 0");
+            emit("setne dl");
+            emit("%s eax, edx", op == OP_AND ? "and" : "or");
             StoreVar(file, "eax", "al", result);
             break;
+        }
         case OP_JMP:
             emit("jmp %s", target->label.c_str());
             break;
         case OP_JT:
-            LoadVar(file, "eax", "al", arg1);
-            emit("cmp eax, 0");
-            emit("jne %s", target->label.c_str());
-            break;
         case OP_JF:
-            LoadVar(file, "eax", "al", arg1);
-            emit("cmp eax, 0");
-            emit("je %s", target->label.c_str());
+        {
+            string src = UseVar(file, "eax", "al", arg1);
+            emit("cmp %s, 0", src.c_str());
+            emit("%s %s", op == OP_JT ? "jne" : "je", target->label.c_str());
             break;
+        }
+        case OP_JG:
+        case OP_JGE:
+        case OP_JL:
+        case OP_JLE:
+        case OP_JE:
         case OP_JNE:
+        {
+            static const char* jcc[] = {"jg", "jge", "jl", "jle", "je", "jne"};
+            string a = UseVar(file, "eax", "al", arg1);
+            string b = UseVar(file, "edx", "dl", arg2);
+            emit("cmp %s, %s", a.c_str(), b.c_str());
+            emit("%s %s", jcc[op - OP_JG], target->label.c_str());
+            break;
+        }
+        case OP_JTAB:
+        {
+            // one unsigned compare bounds the index, the table goes to .rodata
+            string tab = GenIR::GenLb();
             LoadVar(file, "eax", "al", arg1);
-            LoadVar(file, "ebx", "bl", arg2);
-            emit("cmp eax, ebx");
-            emit("jne %s", target->label.c_str());
+            if (arg2->getVal())
+                emit("sub eax, %d", arg2->getVal());
+            emit("cmp eax, %d", (int)table.size() - 1);
+            emit("ja %s", target->label.c_str());
+            emit("jmp [%s+eax*4]", tab.c_str());
+            fprintf(file, ".section .rodata\n");
+            fprintf(file, "%s:\n", tab.c_str());
+            for (int i = 0; i < table.size(); i++)
+                emit(".word %s", table[i]->label.c_str());
+            fprintf(file, ".text\n");
             break;
+        }
         case OP_ARG:
-            LoadVar(file, "eax", "al", arg1);
-            emit("push eax");
+        {
+            string src = UseVar(file, "eax", "al", arg1);
+            emit("push %s", src.c_str());
             break;
+        }
+        case OP_CALL:
         case OP_PROC:
+            if (tail)
+            {
+                // arguments over ours, then leave the frame and let the callee return
+                vector<Var*>& paras = fun->getParaVar();
+                for (int i = 0; i < paras.size(); i++)
+                {
+                    emit("move eax, [esp+%d]", i * 4);
+                    emit("move [ebp%+d], eax", paras[i]->getOffset());
+                }
+                RestoreRegs(file, owner);
+                emit("move esp, ebp");
+                emit("pop ebp");
+                emit("jmp %s", fun->getName().c_str());
+                break;
+            }
             emit("call %s", fun->getName().c_str());
             emit("add esp, %lu", fun->getParaVar().size() * 4);
             StoreVar(file, "eax", "al", result);
@@ -652,15 +926,19 @@ void InterInst::ToX86(FILE* file)
             StoreVar(file, "eax", "al", result);
             break;
         case OP_SET:
-            LoadVar(file, "eax", "al", result);
-            LoadVar(file, "ebx", "bl", arg1);
-            emit("move [ebx], eax");
+        {
+            string val = UseVar(file, "eax", "al", result);
+            string ptr = UseVar(file, "edx", "dl", arg1);
+            emit("move [%s], %s", ptr.c_str(), val.c_str());
             break;
+        }
         case OP_GET:
-            LoadVar(file, "eax", "al", arg1);
-            emit("move eax, [eax]");
+        {
+            string ptr = UseVar(file, "eax", "al", arg1);
+            emit("move eax, [%s]", ptr.c_str());
             StoreVar(file, "eax", "al", result);
             break;
+        }
     }
 }
 
@@ -699,12 +977,41 @@ InterCode::~InterCode()
 	}
 }
 
+/*
+	Free all instructions and their storage
+*/
+void InterCode::clear()
+{
+	for(int i=0;i<code.size();i++)
+	{
+		delete code[i];
+	}
+	vector<InterInst*>().swap(code);
+}
+
+/*
+	Free the instructions marked isDead, returns the count
+*/
+int InterCode::removeDead()
+{
+	int n=0;
+	for(int i=0;i<code.size();i++){
+		if(code[i]->isDead)delete code[i];
+		else code[n++]=code[i];
+	}
+	int removed=code.size()-n;
+	code.resize(n);
+	return removed;
+}
+
 /*
 	标识“首指令”
 */
 void InterCode::markFirst()
 {
 	unsigned int len=code.size();//指令个数，最少为2
+	for(unsigned int i=0;i<len;++i)//code may have changed since the last marking
+		code[i]->clearFirst();
 	//标识Entry与Exit
 	code[0]->setFirst();
 	code[len-1]->setFirst();
@@ -715,6 +1022,8 @@ void InterCode::markFirst()
 		if(code[i]->isJmp()||code[i]->isJcond()){//（直接/条件）跳转指令目标和紧跟指令都是首指令
 			code[i]->getTarget()->setFirst();
 			code[i+1]->setFirst();
+			vector<InterInst*>&table=code[i]->getTable();//跳转表的目标也是首指令
+			for(int k=0;k<table.size();k++)table[k]->setFirst();
 		}
 	}
 }
@@ -5,6 +5,7 @@
 
 class Var;
 class Fun;
+class Block;
 /*
 	四元式类，定义了中间代码的指令的形式
 */
@@ -22,14 +23,16 @@ private:
 	Fun*fun;//函数
 	//};
 	Var *arg2;//参数2
+	vector<InterInst*>table;//跳转表，JTAB的目标标签
 
 	bool first;//是否是首指令
+	bool tail;//tail call, jumps to the callee in our frame
 	void init();//初始化
 
 public:	
 
 	//初始化
-//	Block*block;//指令所在的基本块指针
+	Block*block;//指令所在的基本块指针，set by DFG
 
 	//数据流信息
 	vector<double>inVals;//常量传播in集合
@@ -52,37 +55,51 @@ public:
 	InterInst (Operator op,Var *arg1=NULL);//参数进栈指令,NOP
 	InterInst ();//产生唯一标号
 	InterInst (Operator op,InterInst *tar,Var *arg1=NULL,Var *arg2=NULL);//条件跳转指令,return
+	InterInst (Operator op,InterInst *tar,vector<InterInst*>&table,Var *arg1,Var *arg2);//跳转表指令
 	void replace(Operator op,Var *rs,Var *arg1,Var *arg2=NULL);//替换表达式指令信息，用于常量表达式处理
 	void replace(Operator op,InterInst *tar,Var *arg1=NULL,Var *arg2=NULL);//替换跳转指令信息，条件跳转优化
 	~InterInst();//清理常量内存
 	
 	//外部调用接口
 	void setFirst();//标记首指令
+	void clearFirst();//clear the leader mark
+	void setTail();//mark a call in tail position
+	bool isTail();//call jumping in our frame
 	
 	bool isJcond();//是否条件转移指令JT,JF,Jcond
-	bool isJmp();//是否直接转移指令JMP,return
+	bool isJmp();//是否直接转移指令JMP,return,JTAB
 	bool isFirst();//是首指令
 	bool isLb();//是否是标签
 	bool isDec();//是否是声明
 	bool isExpr();//是基本类型表达式运算,可以对指针取值
 	bool unknown();//不确定运算结果影响的运算(指针赋值，函数调用)
+	vector<Var*>& getWrites();//globals written by a call with known effects
+	Var* getDef();//variable written by the instruction, NULL if none
+	int getUses(Var*uses[2]);//variables read by the instruction, returns the count
+	int replaceUse(Var*from,Var*to);//read to instead of from, returns the count
+	int replaceTarget(InterInst*from,InterInst*to);//jump to instead of from, returns the count
 	
 	Operator getOp();//获取操作符
 	void callToProc();//替换操作符，用于将CALL转化为PROC
 	InterInst* getTarget();//获取跳转指令的目标指令
+	vector<InterInst*>& getTable();//获取跳转表
+	InterInst* caseOf(int val);//label a jump table goes to for val
 	Var* getResult();//获取返回值
 	Var* getArg1();//获取第一个参数
 	Var* getArg2();//获取第二个参数
 	string getLabel();//获取标签
 	Fun* getFun();//获取函数对象
 	void setArg1(Var*arg1);//设置第一个参数
+	void setResult(Var*result);//set the result
 	void toString();//输出指令
     string InstToStr(); // string of IR
     void LoadVar(FILE* file, string reg32, string reg8, Var* pVar);
     void StoreVar(FILE* file, string reg32, string reg8, Var* pVar);
+    string UseVar(FILE* file, string reg32, string reg8, Var* pVar); // register holding the operand
+    void RestoreRegs(FILE* file, Fun* owner); // reload the callee saved registers of owner
     void LeaVar(FILE* file, string reg32, Var* pVar);
     void InitVar(FILE* file, Var* pVar);
-    void ToX86(FILE* file);
+    void ToX86(FILE* file, Fun* owner); // owner is the function being emitted
 };
 
 /*
@@ -98,6 +115,8 @@ public:
 	
 	//管理操作
 	void addInst(InterInst*inst);//添加一条中间代码
+	void clear();//free all instructions and their storage
+	int removeDead();//free the instructions marked isDead, returns the count
 	
 	//关键操作
 	void markFirst();//标识“首指令”
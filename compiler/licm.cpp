@@ -0,0 +1,223 @@
+#include "licm.h"
+#include "liveVar.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+#include "args.h"
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+
+LoopInvariant::LoopInvariant(Fun*fun):fun(fun),rounds(0),hoisted(0),preheaders(0)
+{
+}
+
+static bool byRpo(Block*a,Block*b)
+{
+	return a->rpo<b->rpo;
+}
+
+/*
+	Find the invariant instructions of a loop. An instruction moves when
+	its operands are invariant and its result
+		has no other definition in the loop and is not live into the header,
+		so every read in the loop sees this value,
+		is dead at the loop exits unless its block dominates all of them.
+	Loads and divisions that may trap must also dominate the exits, they
+	would run anyway before the loop is left. The entering jumps are
+	redirected to the preheader label when something moves.
+*/
+bool LoopInvariant::invariants(DFG*dfg,LiveVar*live,Loop*loop,Motion&m)
+{
+	for(int i=0;i<seen.size();i++){
+		int v=seen[i];
+		defs[v]=0;
+		defOf[v]=NULL;
+		declared[v]=0;
+	}
+	seen.clear();
+	Block*h=loop->header;
+	InterInst*lb=h->insts[0];
+	if(!lb->isLb())return false;
+	//the preheader goes right before the label, nothing in the loop may fall into it
+	vector<Block*>&all=dfg->getBlocks();
+	if(h->id>0){
+		Block*lp=all[h->id-1];
+		if(loop->contains(lp)&&(lp->insts.empty()||!lp->insts.back()->isJmp()))return false;
+	}
+	//exits of the loop
+	vector<Block*>exits,targets;
+	for(int i=0;i<loop->blocks.size();i++){
+		Block*b=loop->blocks[i];
+		for(int j=0;j<b->succs.size();j++)
+			if(!loop->contains(b->succs[j])){
+				exits.push_back(b);
+				targets.push_back(b->succs[j]);
+			}
+	}
+	//definitions, declarations and memory writes in the loop
+	VarIndex&vars=live->getVars();
+	bool store=false,call=false;
+	for(int i=0;i<loop->blocks.size();i++){
+		Block*b=loop->blocks[i];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb())continue;
+			Operator op=inst->getOp();
+			if(op==OP_SET)store=true;
+			if((op==OP_CALL||op==OP_PROC)&&inst->unknown())call=true;
+			if(!inst->getWrites().empty())store=true;//a call writing globals
+			if(op==OP_DEC&&inst->getArg1()->getName()[0]!='.'){//its scope may share the slot, temporaries are laid out by live range
+				declared[inst->getArg1()->index]=1;
+				seen.push_back(inst->getArg1()->index);
+			}
+			Var*def=inst->getDef();
+			if(!VarIndex::tracked(def))continue;
+			defs[def->index]++;
+			defOf[def->index]=inst;
+			seen.push_back(def->index);
+			if(vars.isMem(def))store=true;
+		}
+	}
+	vector<Block*>body(loop->blocks);
+	sort(body.begin(),body.end(),byRpo);
+	vector<char>domExits(body.size(),0);
+	for(int i=0;i<body.size();i++){
+		bool dom=!exits.empty();
+		for(int j=0;dom&&j<exits.size();j++)
+			dom=dfg->dominates(body[i],exits[j]);
+		domExits[i]=dom;
+	}
+	Set&headIn=live->getIn(h);
+	unordered_set<InterInst*>inv;
+	bool changed=true;
+	while(changed){
+		changed=false;
+		for(int i=0;i<body.size();i++){
+			Block*b=body[i];
+			for(int j=0;j<b->insts.size();j++){
+				InterInst*inst=b->insts[j];
+				Operator op=inst->getOp();
+				if(inst->isLb()||inv.count(inst))continue;
+				if(!(op>=OP_AS&&op<=OP_OR||op==OP_GET||op==OP_LEA))continue;
+				//operands
+				bool ok=true;
+				if(op!=OP_LEA){//the address of a variable never changes
+					Var*uses[2];
+					int n=inst->getUses(uses);
+					for(int k=0;ok&&k<n;k++){
+						Var*v=uses[k];
+						if(!VarIndex::tracked(v)||!v->notConst()||v->getArray())continue;
+						if(vars.isMem(v)&&(store||call))ok=false;
+						else if(defs[v->index])
+							ok=defs[v->index]==1&&inv.count(defOf[v->index]);
+					}
+				}
+				if(!ok)continue;
+				//result
+				Var*res=inst->getResult();
+				if(!VarIndex::tracked(res)||vars.isMem(res)||res->getArray())continue;
+				int r=res->index;
+				if(defs[r]!=1||declared[r]||headIn.get(r))continue;
+				if(op==OP_GET&&(store||call))continue;//memory may change between iterations
+				bool trap=op==OP_GET;
+				if(op==OP_DIV||op==OP_MOD){
+					Var*d=inst->getArg2();
+					trap=d->notConst()||d->getVal()==0||d->getVal()==-1;
+				}
+				if(!domExits[i]){
+					if(trap)continue;
+					bool used=false;
+					for(int k=0;!used&&k<targets.size();k++)
+						used=live->getIn(targets[k]).get(r);
+					if(used)continue;
+				}
+				inv.insert(inst);
+				m.insts.push_back(inst);
+				changed=true;
+			}
+		}
+	}
+	if(m.insts.empty())return false;
+	//redirect the jumps entering the loop
+	m.header=lb;
+	m.pre=new InterInst();
+	for(int i=0;i<h->prevs.size();i++){
+		Block*p=h->prevs[i];
+		if(loop->contains(p))continue;
+		p->insts.back()->replaceTarget(lb,m.pre);
+	}
+	return true;
+}
+
+/*
+	One round over the loop nest. A loop whose inner loop moved code this
+	round waits for the next one, its body changed under the analysis.
+*/
+bool LoopInvariant::round()
+{
+	InterCode&code=fun->getInterCode();
+	vector<Motion>motions;
+	{
+		DFG dfg(code);
+		vector<Loop*>&loops=dfg.getLoops();
+		rounds++;
+		if(loops.empty())return false;
+		LiveVar live(&dfg,code.getCode());
+		if(live.isLocal())return false;
+		int n=live.getVars().size();
+		defs.assign(n,0);
+		defOf.assign(n,NULL);
+		declared.assign(n,0);
+		seen.clear();
+		unordered_set<Loop*>busy;//loops that moved code or wait for the next round
+		for(int i=0;i<loops.size();i++){
+			Loop*loop=loops[i];
+			bool wait=false;
+			for(int k=0;!wait&&k<loop->kids.size();k++)
+				wait=busy.count(loop->kids[k])>0;
+			Motion m;
+			if(wait||invariants(&dfg,&live,loop,m)){
+				busy.insert(loop);
+				if(!wait)motions.push_back(m);
+			}
+		}
+	}
+	if(motions.empty())return false;
+	//rewrite: hoisted instructions leave their place and follow the preheader label
+	vector<InterInst*>&insts=code.getCode();
+	unordered_set<InterInst*>moved;
+	unordered_map<InterInst*,int>at;//loop label -> motion
+	for(int i=0;i<motions.size();i++){
+		at[motions[i].header]=i;
+		moved.insert(motions[i].insts.begin(),motions[i].insts.end());
+		hoisted+=motions[i].insts.size();
+		preheaders++;
+	}
+	vector<InterInst*>out;
+	out.reserve(insts.size()+motions.size());
+	for(int i=0;i<insts.size();i++){
+		InterInst*inst=insts[i];
+		if(moved.count(inst))continue;
+		unordered_map<InterInst*,int>::iterator it=at.find(inst);
+		if(it!=at.end()){
+			Motion&m=motions[it->second];
+			out.push_back(m.pre);
+			out.insert(out.end(),m.insts.begin(),m.insts.end());
+		}
+		out.push_back(inst);
+	}
+	insts.swap(out);
+	return true;
+}
+
+/*
+	执行循环不变量外提
+*/
+void LoopInvariant::hoist()
+{
+	while(round());
+	if(Args::stats)
+		fprintf(stderr,"%s: loop invariant code motion %d instructions hoisted, %d preheaders in %d rounds\n",
+			fun->getName().c_str(),hoisted,preheaders,rounds);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.h"
+
+class Fun;
+class InterInst;
+class Block;
+class Loop;
+class DFG;
+class LiveVar;
+
+/*
+	Loop invariant code motion over the loop nest of the DFG.
+	A computation is invariant when each operand is a literal, is not
+	written in the loop, or has one definition in the loop which is itself
+	invariant. Memory variables only count as unchanged when the loop has
+	no store through a pointer, no direct write to memory and no call
+	other than to a function summarized as writing no memory.
+	Invariant instructions move, in their original order, to a preheader:
+	a new label placed before the loop label, which the entering jumps are
+	redirected to. Rounds handle the loops inner first until nothing moves,
+	so code climbs one nesting level per round.
+*/
+class LoopInvariant
+{
+	Fun*fun;
+	int rounds;//rounds over the loop nest
+	int hoisted;//instructions moved
+	int preheaders;//preheaders inserted
+	//per loop facts by Var::index, only the entries in seen are reset
+	vector<int>defs;//definitions in the loop
+	vector<InterInst*>defOf;//a definition in the loop
+	vector<char>declared;//named variable declared in the loop
+	vector<int>seen;//indices set by the last loop
+
+	//instructions of one loop moving to its preheader
+	struct Motion
+	{
+		InterInst*header;//label of the loop
+		InterInst*pre;//label of the preheader
+		vector<InterInst*>insts;//hoisted instructions in order
+	};
+
+	bool invariants(DFG*dfg,LiveVar*live,Loop*loop,Motion&m);//find the invariants of a loop
+	bool round();//one round, true if something moved
+public:
+	LoopInvariant(Fun*fun);
+
+	void hoist();//执行循环不变量外提
+};
@@ -0,0 +1,67 @@
+#include "liveVar.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+
+/*
+	Compute gen (upward exposed uses) and kill (definitions) of every block
+	by walking it backwards, then solve
+*/
+LiveVar::LiveVar(DFG*dfg,vector<InterInst*>&code)
+	:DataFlow(dfg,BACKWARD,UNION),vars(code)
+{
+	if(!init(vars.size()))return;
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		Set&g=gen[b->id];
+		Set&k=kill[b->id];
+		for(int j=b->insts.size()-1;j>=0;j--){
+			InterInst*inst=b->insts[j];
+			Var*def=inst->getDef();
+			if(VarIndex::tracked(def)){
+				g.reset(def->index);
+				k.set(def->index);
+			}
+			step(inst,g);
+		}
+	}
+	solve(vars.getGlobals());
+}
+
+/*
+	Live after inst -> live before inst
+*/
+void LiveVar::step(InterInst*inst,Set&live)
+{
+	Var*def=inst->getDef();
+	if(VarIndex::tracked(def))live.reset(def->index);
+	Var*uses[2];
+	int n=inst->getUses(uses);
+	for(int i=0;i<n;i++)
+		if(VarIndex::tracked(uses[i]))live.set(uses[i]->index);
+	Operator op=inst->getOp();
+	if(op==OP_GET||op==OP_CALL||op==OP_PROC)
+		live.unite(vars.getMem());
+}
+
+/*
+	Variable numbering
+*/
+VarIndex&LiveVar::getVars()
+{
+	return vars;
+}
+
+/*
+	Print live in and out of every block
+*/
+void LiveVar::toString()
+{
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		printf("B%d live in: %s\n",b->id,vars.toString(getIn(b)).c_str());
+		printf("B%d live out: %s\n",b->id,vars.toString(getOut(b)).c_str());
+	}
+}
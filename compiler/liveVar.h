@@ -0,0 +1,19 @@
+#pragma once
+
+#include "dataFlow.h"
+
+/*
+	Live variables, a backward union problem over VarIndex.
+	Loads and calls may read any memory variable, globals stay live at the
+	exit of the function.
+*/
+class LiveVar:public DataFlow
+{
+	VarIndex vars;
+public:
+	LiveVar(DFG*dfg,vector<InterInst*>&code);
+
+	void step(InterInst*inst,Set&live);//live after inst -> live before inst
+	VarIndex&getVars();//variable numbering
+	void toString();//print live in and out of every block
+};
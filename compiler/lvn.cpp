@@ -0,0 +1,257 @@
+#include "lvn.h"
+#include "constProp.h"
+#include "dataFlow.h"
+#include "pointsTo.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+
+/*
+	Same expression
+*/
+bool LocalValueNumbering::Key::operator==(const Key&k) const
+{
+	return op==k.op&&a==k.a&&b==k.b&&epoch==k.epoch;
+}
+
+/*
+	Hash of an expression
+*/
+size_t LocalValueNumbering::KeyHash::operator()(const Key&k) const
+{
+	size_t h=k.op;
+	h=h*1000003u^(unsigned)k.a;
+	h=h*1000003u^(unsigned)k.b;
+	return h*1000003u^(unsigned)k.epoch;
+}
+
+/*
+	Operators whose operands can be swapped
+*/
+static bool commutative(Operator op)
+{
+	switch(op){
+		case OP_ADD:case OP_MUL:case OP_EQU:case OP_NE:case OP_AND:case OP_OR:
+		case OP_BAND:case OP_BOR:case OP_BXOR:return true;
+		default:return false;
+	}
+}
+
+LocalValueNumbering::LocalValueNumbering(Fun*fun,SymTab*tab)
+	:fun(fun),tab(tab),vars(NULL),alias(NULL),redundant(0),folded(0),operands(0),blocks(0),block(0),memEpoch(0),loadEpoch(0)
+{
+	newValue(NULL);//0 is no value
+}
+
+LocalValueNumbering::~LocalValueNumbering()
+{
+	delete alias;
+	delete vars;
+}
+
+/*
+	Fresh value number
+*/
+int LocalValueNumbering::newValue(Var*var)
+{
+	holder.push_back(var);
+	constOf.push_back(0);
+	isConst.push_back(0);
+	return holder.size()-1;
+}
+
+/*
+	Value number of a constant, shared by all the blocks
+*/
+int LocalValueNumbering::constant(int val)
+{
+	unordered_map<int,int>::iterator it=constVal.find(val);
+	if(it!=constVal.end())return it->second;
+	int v=newValue(NULL);
+	constOf[v]=val;
+	isConst[v]=1;
+	constVal[val]=v;
+	return v;
+}
+
+/*
+	The variable still holds the value: set in this block, and for an
+	escaped variable after the last call or store through a wild pointer.
+	The stores through known pointers reset their targets. An array is a
+	fixed address.
+*/
+bool LocalValueNumbering::holds(Var*var,int val)
+{
+	if(!var)return false;
+	int i=var->index;
+	if(setIn[i]!=block||valOf[i]!=val)return false;
+	return !vars->isMem(var)||var->getArray()||!alias->isEscaped(var)||setAt[i]==memEpoch;
+}
+
+/*
+	Value number of an operand, 0 if none. A variable not set in this
+	block holds a value of its own.
+*/
+int LocalValueNumbering::value(Var*var)
+{
+	if(!var)return 0;
+	if(var->isLiteral())return constant(var->getVal());
+	if(!VarIndex::tracked(var))return newValue(NULL);
+	int i=var->index;
+	if(!holds(var,valOf[i]))assign(var,newValue(var));
+	return valOf[i];
+}
+
+/*
+	The variable holds the value from now on, and becomes its holder when
+	the value has none left
+*/
+void LocalValueNumbering::assign(Var*var,int val)
+{
+	int i=var->index;
+	valOf[i]=val;
+	setIn[i]=block;
+	setAt[i]=memEpoch;
+	if(!isConst[val]&&!holds(holder[val],val))holder[val]=var;
+}
+
+/*
+	Literal variable
+*/
+Var* LocalValueNumbering::literal(int val)
+{
+	unordered_map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	Number one instruction: operands holding constants become literals,
+	then a computation folds, reuses a variable holding its value or gives
+	its result a new value
+*/
+void LocalValueNumbering::visit(InterInst*inst)
+{
+	Operator op=inst->getOp();
+	//operands read as values can become literals, SET stores its result field
+	Var*args[3]={inst->getResult(),inst->getArg1(),inst->getArg2()};
+	int first=1,last=2;
+	if(op==OP_SET)first=last=0;
+	else if(!(op==OP_AS||op>=OP_ADD&&op<=OP_OR||op==OP_ARG||op==OP_RETV||inst->isJcond()))last=0;
+	int replaced=0;
+	for(int k=first;k<=last;k++){
+		if(!VarIndex::tracked(args[k]))continue;
+		int v=value(args[k]);
+		if(isConst[v]){
+			args[k]=literal(constOf[v]);
+			replaced++;
+		}
+	}
+	if(replaced){
+		operands+=replaced;
+		if(op==OP_RETV||inst->isJcond())inst->replace(op,inst->getTarget(),args[1],args[2]);
+		else inst->replace(op,args[0],args[1],args[2]);
+	}
+	Var*def=inst->getDef();
+	int val=0;
+	if(op==OP_AS)val=value(inst->getArg1());
+	else if(op>=OP_ADD&&op<=OP_OR||op==OP_GET){
+		int a=value(inst->getArg1()),b=value(inst->getArg2());
+		double v=NAC;
+		if(op!=OP_GET){
+			double x=isConst[a]?constOf[a]:NAC,y=b?(isConst[b]?constOf[b]:NAC):0;
+			v=ConstPropagation::fold(op,x,y);
+			if(a==b&&v==NAC){//the same value on both sides
+				if(op==OP_SUB||op==OP_BXOR||op==OP_NE||op==OP_GT||op==OP_LT)v=0;
+				else if(op==OP_EQU||op==OP_GE||op==OP_LE)v=1;
+			}
+		}
+		if(v!=NAC&&v!=UNDEF){
+			val=constant((int)v);
+			inst->replace(OP_AS,def,literal((int)v));
+			folded++;
+		}
+		else{
+			if(commutative(op)&&a>b||op==OP_GT||op==OP_GE){//a>b is b<a
+				int t=a;
+				a=b;
+				b=t;
+				if(op==OP_GT)op=OP_LT;
+				else if(op==OP_GE)op=OP_LE;
+			}
+			Key key={op,a,b,op==OP_GET?loadEpoch:block};
+			unordered_map<Key,int,KeyHash>::iterator it=exprs.find(key);
+			if(it==exprs.end())val=exprs[key]=newValue(NULL);
+			else{
+				val=it->second;
+				Var*h=holder[val];
+				if(holds(h,val)){
+					if(h==def)inst->isDead=true;
+					else inst->replace(OP_AS,def,h);
+					redundant++;
+				}
+			}
+		}
+	}
+	if(op==OP_SET){//a store changes its targets, or every escaped variable
+		Var*p=inst->getArg1();
+		Set&to=alias->getTargets(p);
+		for(int o=to.next(0);o!=-1;o=to.next(o+1)){
+			Var*obj=alias->getObj(o);
+			if(!obj->getArray())setIn[obj->index]=-1;
+		}
+		if(alias->isWild(p))memEpoch++;
+		loadEpoch++;
+	}
+	else if(inst->unknown()){//calls change the escaped variables
+		memEpoch++;
+		loadEpoch++;
+	}
+	vector<Var*>&writes=inst->getWrites();//a summarized call writes its globals only
+	for(int k=0;k<writes.size();k++){
+		if(vars->has(writes[k]))setIn[writes[k]->index]=-1;
+		loadEpoch++;
+	}
+	int ret;
+	if(op==OP_CALL&&inst->getFun()->constReturn(ret))val=constant(ret);
+	if(!VarIndex::tracked(def))return;
+	if(!val)val=newValue(NULL);
+	else if(def->isChar()){//stored in a byte, loaded zero extended
+		if(isConst[val])val=constant((unsigned char)constOf[val]);
+		else if(op!=OP_AS||!inst->getArg1()->isChar())val=newValue(NULL);
+	}
+	assign(def,val);
+	if(vars->isMem(def))loadEpoch++;//a pointer may read it
+}
+
+/*
+	执行局部值编号
+*/
+void LocalValueNumbering::number()
+{
+	InterCode&ir=fun->getInterCode();
+	vector<InterInst*>&code=ir.getCode();
+	vars=new VarIndex(code);
+	alias=new PointsTo(*vars,code);
+	valOf.assign(vars->size(),0);
+	setIn.assign(vars->size(),-1);
+	setAt.assign(vars->size(),-1);
+	ir.markFirst();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isFirst()){
+			block++;
+			loadEpoch++;
+			blocks++;
+		}
+		if(!inst->isLb())visit(inst);
+	}
+	ir.removeDead();
+	if(Args::stats)
+		fprintf(stderr,"%s: local value numbering %d blocks, %d redundant, %d folded, %d operands\n",
+			fun->getName().c_str(),blocks,redundant,folded,operands);
+}
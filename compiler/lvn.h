@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+class Var;
+class Fun;
+class SymTab;
+class InterInst;
+class VarIndex;
+class PointsTo;
+
+/*
+	Local value numbering over the basic blocks of InterCode::markFirst.
+	Every value computed in a block gets a number, operands are numbered
+	by the value they hold and an expression by its operator and operand
+	numbers, in a fixed order for commutative operators and with a>b read
+	as b<a. A recomputation becomes a copy of a variable still holding the
+	value, an operation on constants or on one value twice (x-x, x==x)
+	becomes a copy of a literal and operands holding a constant become
+	literals.
+	A store changes the variables its pointer may point to and the loads,
+	a store through a wild pointer or a call every escaped variable (see
+	PointsTo), a call with a known summary only the globals it writes. A
+	write to a memory variable changes the loads. Char variables hold a truncated
+	value and get a number of their own.
+	One walk over the code with hash tables, so the cost stays linear.
+*/
+class LocalValueNumbering
+{
+	//an expression of value numbers
+	struct Key
+	{
+		int op;
+		int a,b;//operand numbers, 0 if none
+		int epoch;//memory state of a load, block of the others
+		bool operator==(const Key&k) const;
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key&k) const;
+	};
+
+	Fun*fun;
+	SymTab*tab;
+	VarIndex*vars;
+	PointsTo*alias;
+	int redundant;//recomputations turned into copies
+	int folded;//operations on constants turned into literal copies
+	int operands;//operands replaced by literals
+	int blocks;//blocks numbered
+
+	//value numbers, 0 is no value
+	vector<Var*>holder;//variable holding every value, NULL for a constant
+	vector<int>constOf;//constant of every value
+	vector<char>isConst;//the value is a constant
+	unordered_map<int,int>constVal;//constant -> value number
+	unordered_map<Key,int,KeyHash>exprs;//expression -> value number
+	unordered_map<int,Var*>literals;//literals created
+
+	//numbers of the variables by VarIndex, valid in one block
+	vector<int>valOf;//value held
+	vector<int>setIn;//block the value was set in
+	vector<int>setAt;//memory epoch the value was set in
+	int block;//current block
+	int memEpoch;//bumped by calls and stores through wild pointers
+	int loadEpoch;//bumped by stores, calls and writes to memory variables
+
+	int newValue(Var*holder);//fresh value number
+	int constant(int val);//value number of a constant
+	int value(Var*var);//value number of an operand
+	void assign(Var*var,int val);//var holds val from now on
+	Var*literal(int val);//literal variable
+	bool holds(Var*var,int val);//var still holds val
+	void visit(InterInst*inst);//number one instruction
+public:
+	LocalValueNumbering(Fun*fun,SymTab*tab);
+	~LocalValueNumbering();
+
+	void number();//执行局部值编号
+};
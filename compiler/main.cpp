@@ -7,24 +7,39 @@
 #include "semanticAnalyzer.h"
 #include "symbolTable.h"
 #include "genIr.h"
+#include "args.h"
+#include "passManager.h"
 
 using namespace std;
 using namespace Compiler;
 
 int main(int argc,char*argv[])
 {
-    string srcFiles = argv[1];
-    Scanner scanner(srcFiles);
+    if (!Args::parse(argc, argv))
+    {
+        Args::usage(argv[0]);
+        return 1;
+    }
 
-    scanner.Init();
+    Scanner scanner(Args::srcFile);
+
+    scanner.Init(Args::emitIr, Args::emitAsm);
 
     SymTab symbolTable;
     GenIR  genIr(symbolTable);
+    if (Args::stream)
+    {
+        symbolTable.SetStream(scanner.GetIrHandle(), scanner.GetOutHandle());
+    }
     SemanticAnalyzer semanticAnalyzer(scanner, symbolTable, genIr);
     semanticAnalyzer.Analyse();
 
-    symbolTable.genIr(scanner.GetIrHandle());
-    symbolTable.genAsm(scanner.GetOutHandle());
+    // one traversal produces every requested output
+    symbolTable.genCode(scanner.GetIrHandle(), scanner.GetOutHandle());
+    if (Args::opt && Args::timePasses)
+    {
+        PassManager::report();
+    }
 
 	return 0;
 }
@@ -0,0 +1,258 @@
+#include "passManager.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "constProp.h"
+#include "redundElim.h"
+#include "copyProp.h"
+#include "deadCode.h"
+#include "inliner.h"
+#include "tailCall.h"
+#include "licm.h"
+#include "indVar.h"
+#include "ssa.h"
+#include "cfgSimplify.h"
+#include "algebra.h"
+#include "lvn.h"
+#include "args.h"
+#include <ctime>
+
+//内联：小函数和叶子函数在调用点展开，随后的优化处理展开的代码
+#ifdef INLINE
+static void inlinePass(Fun*fun,SymTab*tab)
+{
+	Inliner inl(fun,tab,tab->GetCallGraph());
+	inl.expand();
+}
+#endif
+
+//尾递归消除：自身尾调用变为参数赋值和跳转，形成的循环交给循环优化
+//其余的尾调用在代码最终确定后复用栈帧跳转到被调函数
+#ifdef TAIL
+static void tailRecPass(Fun*fun,SymTab*tab)
+{
+	TailCall tail(fun,tab);
+	tail.recursion();
+}
+
+static void tailCallPass(Fun*fun,SymTab*tab)
+{
+	TailCall tail(fun,tab);
+	tail.mark();
+}
+#endif
+
+//常量传播：代数化简，条件跳转优化，不可达代码消除
+//代数化简：恒等式变为复写，乘除模2的幂变为移位和掩码
+#ifdef CONST
+static void constPass(Fun*fun,SymTab*tab)
+{
+	ConstPropagation conPro(fun,tab);
+	conPro.propagate();
+}
+
+static void algebraPass(Fun*fun,SymTab*tab)
+{
+	AlgebraicSimplify alg(fun,tab);
+	alg.simplify();
+}
+#endif
+
+//跳转穿透与控制流图化简
+#ifdef PEEP
+static void cfgPass(Fun*fun,SymTab*)
+{
+	CfgSimplify cfg(fun);
+	cfg.simplify();
+}
+#endif
+
+//局部值编号，冗余消除，循环不变量外提，归纳变量强度削弱
+#ifdef RED
+static void lvnPass(Fun*fun,SymTab*tab)
+{
+	LocalValueNumbering lvn(fun,tab);
+	lvn.number();
+}
+
+static void csePass(Fun*fun,SymTab*tab)
+{
+	RedundElim re(fun,tab);
+	re.elimate();
+}
+
+static void licmPass(Fun*fun,SymTab*)
+{
+	LoopInvariant licm(fun);
+	licm.hoist();
+}
+
+static void ivsPass(Fun*fun,SymTab*tab)
+{
+	InductionVar iv(fun,tab);
+	iv.reduce();
+}
+#endif
+
+//复写传播，死代码消除
+#ifdef DEAD
+static void copyPass(Fun*fun,SymTab*)
+{
+	CopyPropagation cp(fun);
+	cp.propagate();
+}
+
+static void dcePass(Fun*fun,SymTab*)
+{
+	DeadCodeElim dce(fun);
+	dce.eliminate();
+}
+#endif
+
+//SSA构造与还原：变量按定义拆分，复写合并，临时变量按活跃区间共享栈帧
+#ifdef REG
+static void ssaPass(Fun*fun,SymTab*tab)
+{
+	SSA ssa(fun,tab);
+	ssa.build();
+	ssa.destruct();
+}
+#endif
+
+PassManager::Pass PassManager::passes[]={
+#ifdef INLINE
+	{"inline","inline small and leaf functions",inlinePass},
+#endif
+#ifdef TAIL
+	{"tailrec","turn self tail calls into loops",tailRecPass},
+	{"tailcall","let the other tail calls reuse the frame",tailCallPass},
+#endif
+#ifdef CONST
+	{"const","sparse conditional constant propagation",constPass},
+	{"algebra","algebraic identities, shifts for powers of two",algebraPass},
+#endif
+#ifdef PEEP
+	{"cfg","jump threading and control flow graph simplification",cfgPass},
+#endif
+#ifdef RED
+	{"lvn","local value numbering in basic blocks",lvnPass},
+	{"cse","common subexpression elimination",csePass},
+	{"licm","loop invariant code motion",licmPass},
+	{"ivs","induction variable strength reduction",ivsPass},
+#endif
+#ifdef DEAD
+	{"copy","copy propagation",copyPass},
+	{"dce","dead code elimination",dcePass},
+#endif
+#ifdef REG
+	{"ssa","SSA construction and copy coalescing",ssaPass},
+#endif
+	{NULL,NULL,NULL}
+};
+vector<PassManager::Pass*>PassManager::pipeline;
+vector<PassManager::Total>PassManager::totals;
+bool PassManager::chosen=false;
+
+/*
+	Pass by name, NULL if unknown
+*/
+PassManager::Pass* PassManager::find(const string&name)
+{
+	for(Pass*p=passes;p->name;p++)
+		if(name==p->name)return p;
+	return NULL;
+}
+
+/*
+	Fill the pipeline from a comma separated list. Unknown names are an
+	error when strict, otherwise they are compiled out and skipped.
+*/
+bool PassManager::parse(const char*list,bool strict)
+{
+	pipeline.clear();
+	string items=list;
+	size_t start=0;
+	while(start<items.size()){
+		size_t end=items.find(',',start);
+		if(end==string::npos)end=items.size();
+		string item=items.substr(start,end-start);
+		Pass*p=find(item);
+		if(p)pipeline.push_back(p);
+		else if(strict){
+			printf("unknown pass '%s' in --passes\n",item.c_str());
+			return false;
+		}
+		start=end+1;
+	}
+	return true;
+}
+
+/*
+	Use the passes of a --passes list instead of the level pipeline
+*/
+bool PassManager::select(const char*list)
+{
+	chosen=true;
+	return parse(list,true);
+}
+
+/*
+	Run the pipeline on a function, timing every pass with --time-passes
+*/
+void PassManager::run(Fun*fun,SymTab*tab)
+{
+	if(!chosen){
+		parse(Args::opt>1?O2_PASSES:O1_PASSES,false);
+		chosen=true;
+	}
+	if(totals.empty()){
+		Total zero={0,0,0,0};
+		int n=0;
+		while(passes[n].name)n++;
+		totals.assign(n,zero);
+	}
+	for(int i=0;i<pipeline.size();i++){
+		Pass*p=pipeline[i];
+		int before=fun->getCode().size();
+		clock_t t0=clock();
+		p->run(fun,tab);
+		clock_t t1=clock();
+		if(!Args::timePasses)continue;
+		int after=fun->getCode().size();
+		double ms=(t1-t0)*1000.0/CLOCKS_PER_SEC;
+		Total&t=totals[p-passes];
+		t.runs++;
+		t.ms+=ms;
+		t.before+=before;
+		t.after+=after;
+		fprintf(stderr,"%s: pass %s %d -> %d instructions %.3f ms\n",
+			fun->getName().c_str(),p->name,before,after,ms);
+	}
+}
+
+/*
+	Totals per pass over the program, in table order
+*/
+void PassManager::report()
+{
+	double ms=0;
+	fprintf(stderr,"%-10s %6s %10s %s\n","pass","runs","ms","instructions");
+	for(int i=0;i<totals.size();i++){
+		Total&t=totals[i];
+		if(!t.runs)continue;
+		fprintf(stderr,"%-10s %6d %10.3f %ld -> %ld\n",passes[i].name,t.runs,t.ms,t.before,t.after);
+		ms+=t.ms;
+	}
+	fprintf(stderr,"%-10s %6s %10.3f\n","total","",ms);
+}
+
+/*
+	Print the passes and the level pipelines
+*/
+void PassManager::usage()
+{
+	printf("passes:\n");
+	for(Pass*p=passes;p->name;p++)
+		printf("  %-10s %s\n",p->name,p->desc);
+	printf("-O1: %s\n",O1_PASSES);
+	printf("-O2: %s\n",O2_PASSES);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common.h"
+
+class Fun;
+class SymTab;
+
+//pipelines of the -O levels
+#define O1_PASSES "tailrec,const,cfg,lvn,copy,dce,algebra,copy,dce,cfg,tailcall"
+#define O2_PASSES "inline,tailrec,const,cfg,lvn,cse,copy,dce,licm,ivs,algebra,copy,dce,ssa,cfg,tailcall"
+
+/*
+	Per function optimization pipeline.
+	The passes run in the order of a list: the pipeline of the -O level,
+	or the one given with --passes, where a pass may appear more than
+	once. A pass compiled out by its switch in common.h is dropped from
+	the level pipelines and unknown to --passes.
+	With --time-passes every run reports its time and the code size
+	before and after it, and the totals per pass are printed at the end.
+*/
+class PassManager
+{
+	//an optimization pass
+	struct Pass
+	{
+		const char*name;//name in --passes
+		const char*desc;//what it does, for the usage
+		void (*run)(Fun*fun,SymTab*tab);//run on a function
+	};
+	//cost of a pass over the whole program
+	struct Total
+	{
+		int runs;//functions it ran on
+		double ms;//time spent
+		long before;//instructions before
+		long after;//instructions after
+	};
+
+	static Pass passes[];//every pass compiled in, ends with a NULL name
+	static vector<Pass*>pipeline;//passes to run in order
+	static vector<Total>totals;//cost by index in passes
+	static bool chosen;//pipeline selected
+
+	static Pass*find(const string&name);//pass by name, NULL if unknown
+	static bool parse(const char*list,bool strict);//fill the pipeline from a list
+public:
+	static bool select(const char*list);//--passes list, false on an unknown name
+	static void run(Fun*fun,SymTab*tab);//run the pipeline on a function
+	static void report();//totals per pass to stderr
+	static void usage();//print the passes and the level pipelines
+};
@@ -0,0 +1,194 @@
+#include "pointsTo.h"
+#include "symbol.h"
+#include "interCode.h"
+
+/*
+	Find the objects, seed the targets from &x, arrays, loads, calls and
+	parameters, carry them along copies and additions until nothing
+	changes, then mark what the pushes, returns, stores and memory
+	variables let out
+*/
+PointsTo::PointsTo(VarIndex&vars,vector<InterInst*>&code):vars(vars),escapes(0)
+{
+	int n=vars.size();
+	objOf.assign(n,-1);
+	targets.resize(n);
+	wild.assign(n,0);
+	for(int i=0;i<n;i++)
+		if(vars.get(i)->getArray()||vars.get(i)->inMem)addObj(vars.get(i));
+	for(int i=0;i<code.size();i++)
+		if(!code[i]->isLb()&&code[i]->getOp()==OP_LEA)addObj(code[i]->getArg1());
+	escaped.init(objs.size(),false);
+	for(int i=0;i<objs.size();i++)
+		if(objs[i]->getArray())point(objs[i],i);//an array name is its address
+	//seeds, copies and the values leaving the function
+	vector<char>declared(n,0);
+	vector<pair<int,int> >edges;//dst may point where src does
+	vector<Var*>sinks;//their targets escape
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())continue;
+		Operator op=inst->getOp();
+		Var*def=inst->getDef();
+		switch(op){
+			case OP_DEC:{
+				Var*var=inst->getArg1();
+				if(!VarIndex::tracked(var))break;
+				declared[var->index]=1;
+				if(!var->unInit()&&!var->isBase())wild[var->index]=1;//a string
+				break;
+			}
+			case OP_LEA:
+				if(VarIndex::tracked(def)&&VarIndex::tracked(inst->getArg1()))
+					point(def,objOf[inst->getArg1()->index]);
+				break;
+			case OP_AS:case OP_ADD:case OP_SUB:{
+				if(!VarIndex::tracked(def))break;
+				Var*args[2]={inst->getArg1(),inst->getArg2()};
+				for(int k=0;k<2;k++)
+					if(VarIndex::tracked(args[k]))edges.push_back(make_pair(def->index,args[k]->index));
+				break;
+			}
+			case OP_GET:case OP_CALL:
+				if(VarIndex::tracked(def))wild[def->index]=1;
+				break;
+			case OP_ARG:case OP_RETV:
+				sinks.push_back(inst->getArg1());
+				break;
+			case OP_SET:
+				sinks.push_back(inst->getResult());
+				break;
+			default:break;
+		}
+	}
+	//parameters and memory variables hold values from outside
+	Set&mem=vars.getMem();
+	for(int i=0;i<n;i++){
+		Var*var=vars.get(i);
+		if(!var->getArray()&&(mem.get(i)||!declared[i]))wild[i]=1;
+	}
+	bool changed=true;
+	while(changed){
+		changed=false;
+		for(int i=0;i<edges.size();i++)
+			if(flow(edges[i].first,edges[i].second))changed=true;
+	}
+	for(int i=0;i<sinks.size();i++)
+		if(vars.has(sinks[i])&&targets[sinks[i]->index].size())escaped.unite(targets[sinks[i]->index]);
+	for(int i=0;i<n;i++)//what a memory variable holds can be loaded anywhere
+		if(mem.get(i)&&!vars.get(i)->getArray()&&targets[i].size())escaped.unite(targets[i]);
+	for(int i=escaped.next(0);i!=-1;i=escaped.next(i+1))
+		if(objs[i]->getPath().size()>1)escapes++;
+}
+
+/*
+	Make var an object once
+*/
+void PointsTo::addObj(Var*var)
+{
+	if(!vars.has(var)||objOf[var->index]>=0)return;
+	objOf[var->index]=objs.size();
+	objs.push_back(var);
+}
+
+/*
+	Var may point to obj
+*/
+void PointsTo::point(Var*var,int obj)
+{
+	Set&s=targets[var->index];
+	if(!s.size())s.init(objs.size(),false);
+	s.set(obj);
+}
+
+/*
+	Dst may point where src does, true if changed
+*/
+bool PointsTo::flow(int dst,int src)
+{
+	bool changed=false;
+	if(wild[src]&&!wild[dst]){
+		wild[dst]=1;
+		changed=true;
+	}
+	if(targets[src].size()){
+		if(!targets[dst].size())targets[dst].init(objs.size(),false);
+		if(targets[dst].unite(targets[src]))changed=true;
+	}
+	return changed;
+}
+
+/*
+	Ptr may point to any escaped variable. A pointer without targets is
+	taken as wild too, a literal or a string rather than an object.
+*/
+bool PointsTo::isWild(Var*ptr)
+{
+	if(!vars.has(ptr))return true;
+	int i=ptr->index;
+	return wild[i]||targets[i].empty();
+}
+
+/*
+	Objects ptr may point to, besides the escaped variables if it is wild
+*/
+Set&PointsTo::getTargets(Var*ptr)
+{
+	static Set none;
+	return vars.has(ptr)?targets[ptr->index]:none;
+}
+
+/*
+	Variable of an object
+*/
+Var*PointsTo::getObj(int obj)
+{
+	return objs[obj];
+}
+
+/*
+	Global or object reachable from outside the function
+*/
+bool PointsTo::isEscaped(Var*var)
+{
+	if(var->getPath().size()==1)return true;
+	if(!vars.has(var))return false;
+	int o=objOf[var->index];
+	return o>=0&&escaped.get(o);
+}
+
+/*
+	*ptr may be var
+*/
+bool PointsTo::mayAlias(Var*ptr,Var*var)
+{
+	if(isWild(ptr)&&isEscaped(var))return true;
+	if(!vars.has(var))return false;
+	int o=objOf[var->index];
+	Set&s=getTargets(ptr);
+	return o>=0&&s.size()&&s.get(o);
+}
+
+/*
+	A store or a call may write var, its own result aside
+*/
+bool PointsTo::mayWrite(InterInst*inst,Var*var)
+{
+	if(inst->isLb())return false;
+	Operator op=inst->getOp();
+	if(op==OP_SET)return mayAlias(inst->getArg1(),var);
+	if(op!=OP_CALL&&op!=OP_PROC)return false;
+	if(inst->unknown())return isEscaped(var);
+	vector<Var*>&writes=inst->getWrites();
+	for(int i=0;i<writes.size();i++)
+		if(writes[i]==var)return true;
+	return false;
+}
+
+/*
+	Locals whose address escapes
+*/
+int PointsTo::getEscaped()
+{
+	return escapes;
+}
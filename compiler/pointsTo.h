@@ -0,0 +1,40 @@
+#pragma once
+
+#include "dataFlow.h"
+
+/*
+	Flow insensitive points-to analysis of a function.
+	The objects are the variables whose address is taken (&x, Var::inMem)
+	and the arrays, every variable gets the objects it may point to:
+	&x and an array name give their object, copies and additions carry
+	the targets of their operands. A pointer loaded from memory, returned
+	by a call, passed as a parameter or held in a memory variable is wild:
+	it may point to any escaped variable, that is a global or an object
+	whose address is pushed, returned, stored through a pointer or held
+	in a memory variable. A variable whose address stays inside the
+	function is only written by the stores through its own pointers.
+*/
+class PointsTo
+{
+	VarIndex&vars;
+	vector<Var*>objs;//objects: address taken variables and arrays
+	vector<int>objOf;//object of every variable, -1 if none
+	vector<Set>targets;//objects every variable may point to, empty if none
+	vector<char>wild;//variable may point to any escaped variable
+	Set escaped;//objects reachable from outside the function
+	int escapes;//escaped locals, for the statistics
+
+	void addObj(Var*var);//make var an object once
+	void point(Var*var,int obj);//var may point to obj
+	bool flow(int dst,int src);//dst may point where src does, true if changed
+public:
+	PointsTo(VarIndex&vars,vector<InterInst*>&code);
+
+	bool isWild(Var*ptr);//ptr may point to any escaped variable
+	Set&getTargets(Var*ptr);//objects ptr may point to
+	Var*getObj(int obj);//variable of an object
+	bool isEscaped(Var*var);//global or escaped object
+	bool mayAlias(Var*ptr,Var*var);//*ptr may be var
+	bool mayWrite(InterInst*inst,Var*var);//a store or call may write var
+	int getEscaped();//locals whose address escapes
+};
@@ -0,0 +1,84 @@
+#include "reachDef.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "interCode.h"
+
+/*
+	Number the definitions, then compute gen (last definition of every
+	variable in the block) and kill (all definitions of the variables the
+	block defines) and solve
+*/
+ReachDef::ReachDef(DFG*dfg,vector<InterInst*>&code)
+	:DataFlow(dfg,FORWARD,UNION),vars(code)
+{
+	varDefs.resize(vars.size());
+	for(int i=0;i<code.size();i++){
+		Var*def=code[i]->getDef();
+		if(!VarIndex::tracked(def))continue;
+		defIndex[code[i]]=defs.size();
+		varDefs[def->index].push_back(defs.size());
+		defs.push_back(code[i]);
+	}
+	if(!init(defs.size()))return;
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		Set&g=gen[b->id];
+		Set&k=kill[b->id];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			Var*def=inst->getDef();
+			if(!VarIndex::tracked(def))continue;
+			vector<int>&same=varDefs[def->index];
+			for(int d=0;d<same.size();d++)k.set(same[d]);
+			step(inst,g);
+		}
+	}
+	solve(Set(defs.size()));
+}
+
+/*
+	Reaching before inst -> reaching after inst
+*/
+void ReachDef::step(InterInst*inst,Set&reach)
+{
+	Var*def=inst->getDef();
+	if(!VarIndex::tracked(def))return;
+	vector<int>&same=varDefs[def->index];
+	for(int d=0;d<same.size();d++)reach.reset(same[d]);
+	reach.set(defIndex[inst]);
+}
+
+/*
+	Definition with index i
+*/
+InterInst*ReachDef::getDef(int i)
+{
+	return defs[i];
+}
+
+/*
+	Number of definitions
+*/
+int ReachDef::getDefCount()
+{
+	return defs.size();
+}
+
+/*
+	Print reaching in and out of every block, definitions as var@index
+*/
+void ReachDef::toString()
+{
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int k=0;k<2;k++){
+			Set&s=k?getOut(b):getIn(b);
+			printf("B%d reach %s:",b->id,k?"out":"in");
+			for(int d=s.next(0);d!=-1;d=s.next(d+1))
+				printf(" %s@%d",defs[d]->getDef()->getName().c_str(),d);
+			printf("\n");
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dataFlow.h"
+#include <unordered_map>
+
+/*
+	Reaching definitions, a forward union problem over the instructions
+	that define a variable. Stores and calls may also change memory
+	variables, they are not counted as definitions here.
+*/
+class ReachDef:public DataFlow
+{
+	VarIndex vars;
+	vector<InterInst*>defs;//definitions by index
+	vector<vector<int> >varDefs;//definitions of every variable
+	unordered_map<InterInst*,int>defIndex;//definition index of every defining instruction
+public:
+	ReachDef(DFG*dfg,vector<InterInst*>&code);
+
+	void step(InterInst*inst,Set&reach);//reaching before inst -> reaching after inst
+	InterInst*getDef(int i);//definition with index i
+	int getDefCount();//number of definitions
+	void toString();//print reaching in and out of every block
+};
@@ -0,0 +1,77 @@
+#include "redundElim.h"
+#include "availExpr.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <unordered_set>
+
+RedundElim::RedundElim(Fun*fun,SymTab*tab):fun(fun),tab(tab),redundant(0),temps(0)
+{
+}
+
+/*
+	执行冗余消除
+*/
+void RedundElim::elimate()
+{
+	vector<InterInst*>&code=fun->getCode();
+	vector<Var*>holder;//temporary of every expression that is recomputed
+	unordered_set<InterInst*>recomputed;//computations of available expressions
+	{
+		DFG dfg(fun->getInterCode());
+		AvailExpr avail(&dfg,code);
+		holder.assign(avail.getCount(),NULL);
+		vector<int>exprOf(code.size(),-1);
+		for(int i=0;i<code.size();i++)exprOf[i]=avail.getExpr(code[i]);
+		//find the recomputations, walking every reachable block
+		vector<Block*>&order=dfg.getOrder();
+		for(int i=0;i<order.size();i++){
+			Block*b=order[i];
+			avail.enter(b);
+			for(int j=0;j<b->insts.size();j++){
+				InterInst*inst=b->insts[j];
+				int e=avail.getExpr(inst);
+				if(e>=0&&avail.isAvail(e)){
+					recomputed.insert(inst);
+					if(!holder[e]){
+						Var*res=inst->getResult();
+						holder[e]=new Var(res->getPath(),res);
+						tab->AddTemp(holder[e]);
+						temps++;
+					}
+				}
+				avail.step(inst);
+			}
+		}
+		if(!recomputed.empty()){
+			//rewrite: recomputations copy the temporary, computations fill it
+			vector<InterInst*>out;
+			out.reserve(code.size()*2);
+			for(int i=0;i<code.size();i++){
+				InterInst*inst=code[i];
+				out.push_back(inst);
+				if(i==0){
+					for(int e=0;e<holder.size();e++)
+						if(holder[e])out.push_back(new InterInst(OP_DEC,holder[e]));
+				}
+				int e=exprOf[i];
+				if(e<0||!holder[e])continue;
+				Var*res=inst->getResult();
+				if(recomputed.count(inst)){
+					inst->replace(OP_AS,res,holder[e]);
+					redundant++;
+				}
+				else{
+					inst->replace(inst->getOp(),holder[e],inst->getArg1(),inst->getArg2());
+					out.push_back(new InterInst(OP_AS,res,holder[e]));
+				}
+			}
+			code.swap(out);
+		}
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: common subexpressions %d replaced, %d temporaries\n",
+			fun->getName().c_str(),redundant,temps);
+}
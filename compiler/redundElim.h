@@ -0,0 +1,26 @@
+#pragma once
+
+#include "common.h"
+
+class Fun;
+class SymTab;
+
+/*
+	Global common subexpression elimination over available expressions.
+	Every computation of an expression that is recomputed while available
+	also stores into one new temporary; the recomputations become copies
+	of it. When one computation dominates the others this is a copy from
+	that computation. Copy propagation and dead code elimination then
+	remove the copies that are left over.
+*/
+class RedundElim
+{
+	Fun*fun;
+	SymTab*tab;
+	int redundant;//computations replaced by copies
+	int temps;//temporaries created
+public:
+	RedundElim(Fun*fun,SymTab*tab);
+
+	void elimate();//执行冗余消除
+};
@@ -0,0 +1,596 @@
+#include "regAlloc.h"
+#include "symbol.h"
+#include "interCode.h"
+#include "dfg.h"
+#include "liveVar.h"
+#include "args.h"
+#include <algorithm>
+#include <climits>
+
+RegAllocator::RegAllocator(Fun*fun)
+	:fun(fun),code(fun->getCode()),vars(NULL),used(0),coalesced(0)
+{}
+
+/*
+	Register name
+*/
+const char*RegAllocator::name(int reg)
+{
+	static const char*names[REG_COUNT]={"ebx","esi","edi","ecx"};
+	return names[reg];
+}
+
+/*
+	Calls, divisions and shifts by a variable use ecx
+*/
+bool RegAllocator::clobbersEcx(InterInst*inst)
+{
+	switch(inst->getOp()){
+		case OP_CALL:case OP_PROC:case OP_DIV:case OP_MOD:
+			return true;
+		case OP_SHL:case OP_SAR:case OP_SHR:
+			return !inst->getArg2()->isLiteral();
+		default:
+			return false;
+	}
+}
+
+/*
+	Candidate of a variable, -1 if it stays in memory
+*/
+int RegAllocator::candidate(Var*var)
+{
+	return vars->has(var)?nodeOf[var->index]:-1;
+}
+
+/*
+	Scalar locals, parameters and temporaries: no globals, arrays, chars
+	nor variables whose address is taken
+*/
+void RegAllocator::collect()
+{
+	int n=vars->size();
+	nodeOf.assign(n,-1);
+	cands.init(n,false);
+	vector<char>taken(n,0);
+	for(int i=0;i<code.size();i++)
+		if(!code[i]->isLb()&&code[i]->getOp()==OP_LEA&&vars->has(code[i]->getArg1()))
+			taken[code[i]->getArg1()->index]=1;
+	Set&mem=vars->getMem();
+	for(int i=0;i<n;i++){
+		Var*var=vars->get(i);
+		if(mem.get(i)||taken[i]||var->getPath().size()==1||var->isChar())continue;
+		nodeOf[i]=nodes.size();
+		nodes.push_back(var);
+		cands.set(i);
+	}
+}
+
+/*
+	Grow the interval of c to a point
+*/
+void RegAllocator::extend(int c,int point)
+{
+	if(point<starts[c])starts[c]=point;
+	if(point>ends[c])ends[c]=point;
+}
+
+/*
+	Walk the reachable blocks backwards from their live out: every
+	reference adds its point to the interval and its loop weight to the
+	cost, the entry defines the parameters. For coloring a definition
+	interferes with what is live after it, the source of a copy aside,
+	and what lives across a clobber of ecx interferes with ecx.
+*/
+void RegAllocator::scan(DFG&dfg,LiveVar&live,bool graph)
+{
+	int n=nodes.size();
+	cost.assign(n,0);
+	cross.assign(n,0);
+	starts.assign(n,INT_MAX);
+	ends.assign(n,-1);
+	vector<Block*>&blocks=dfg.getBlocks();
+	vector<int>first(blocks.size());//position of the first instruction
+	for(int i=0,p=0;i<blocks.size();p+=blocks[i]->insts.size(),i++)first[i]=p;
+	vector<int>params;
+	vector<Var*>&paras=fun->getParaVar();
+	for(int i=0;i<paras.size();i++){
+		int c=candidate(paras[i]);
+		if(c>=0)params.push_back(c);
+	}
+	vector<Block*>&order=dfg.getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		int f=first[b->id],last=f+b->insts.size()-1;
+		double w=1;
+		for(int d=0;d<b->loopDepth&&d<8;d++)w*=LOOP_WEIGHT;
+		Set now=live.getOut(b)&cands;
+		for(int v=now.next(0);v!=-1;v=now.next(v+1))extend(nodeOf[v],2*last+1);
+		for(int j=b->insts.size()-1;j>=0;j--){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb())continue;
+			int p=f+j;
+			vector<int>defs;
+			if(inst->getOp()==OP_ENTRY)defs=params;
+			else{
+				int d=candidate(inst->getDef());
+				if(d>=0)defs.push_back(d);
+			}
+			int src=-1;//copy between candidates
+			if(inst->getOp()==OP_AS&&!defs.empty())src=candidate(inst->getArg1());
+			if(clobbersEcx(inst)){
+				clobbers.push_back(p);
+				if(graph)
+					for(int v=now.next(0);v!=-1;v=now.next(v+1))
+						if(defs.empty()||nodeOf[v]!=defs[0]){
+							cross[nodeOf[v]]=1;
+							addEdge(nodeOf[v]+1,0);
+						}
+			}
+			for(int k=0;k<defs.size();k++){
+				int d=defs[k];
+				extend(d,2*p+1);
+				cost[d]+=w;
+				if(graph)
+					for(int v=now.next(0);v!=-1;v=now.next(v+1))
+						if(nodeOf[v]!=src)addEdge(nodeOf[v]+1,d+1);
+			}
+			if(graph&&src>=0&&src!=defs[0])addMove(defs[0]+1,src+1);
+			for(int k=0;k<defs.size();k++)now.reset(nodes[defs[k]]->index);
+			Var*uses[2];
+			int u=inst->getUses(uses);
+			for(int k=0;k<u;k++){
+				int c=candidate(uses[k]);
+				if(c<0)continue;
+				extend(c,2*p);
+				cost[c]+=w;
+				now.set(nodes[c]->index);
+			}
+		}
+		for(int v=now.next(0);v!=-1;v=now.next(v+1))extend(nodeOf[v],2*f);
+	}
+}
+
+/*
+	Free register for c, -1 if none: ecx first when c does not live across
+	a clobber, then the callee saved registers already saved
+*/
+int RegAllocator::pick(int c,int busy)
+{
+	if(!cross[c]&&!(busy>>REG_ECX&1))return REG_ECX;
+	for(int k=0;k<REG_ECX;k++)
+		if(!(busy>>k&1)&&(used>>k&1))return k;
+	for(int k=0;k<REG_ECX;k++)
+		if(!(busy>>k&1))return k;
+	return -1;
+}
+
+/*
+	Intervals in order of their start, a register is free again after the
+	end of its interval. Without a free register the cheapest of the
+	current one and the holders of a register it may use stays in memory.
+*/
+void RegAllocator::linearScan()
+{
+	//a hull lives across a clobber when it covers both of its points
+	sort(clobbers.begin(),clobbers.end());
+	vector<int>order;
+	for(int c=0;c<nodes.size();c++){
+		if(ends[c]<0)continue;
+		auto it=lower_bound(clobbers.begin(),clobbers.end(),(starts[c]+1)/2);
+		if(it!=clobbers.end()&&2*(*it)+1<=ends[c])cross[c]=1;
+		order.push_back(c);
+	}
+	sort(order.begin(),order.end(),[this](int a,int b){
+		return starts[a]<starts[b]||(starts[a]==starts[b]&&a<b);
+	});
+	int owner[REG_COUNT];
+	fill(owner,owner+REG_COUNT,-1);
+	for(int i=0;i<order.size();i++){
+		int c=order[i],busy=0;
+		for(int k=0;k<REG_COUNT;k++){
+			if(owner[k]>=0&&ends[owner[k]]<starts[c])owner[k]=-1;
+			if(owner[k]>=0)busy|=1<<k;
+		}
+		int reg=pick(c,busy);
+		if(reg<0){
+			for(int k=0;k<REG_COUNT;k++){
+				if(k==REG_ECX&&cross[c])continue;
+				if(reg<0||cost[owner[k]]<cost[owner[reg]])reg=k;
+			}
+			if(reg<0||cost[owner[reg]]>=cost[c])continue;
+			nodes[owner[reg]]->regId=-1;
+		}
+		owner[reg]=c;
+		nodes[c]->regId=reg;
+		used|=1<<reg;
+	}
+}
+
+/*
+	Interference edge, the adjacency of ecx is not kept
+*/
+void RegAllocator::addEdge(int u,int v)
+{
+	if(u==v||adjSet[u].get(v))return;
+	adjSet[u].set(v);
+	adjSet[v].set(u);
+	if(state[u]!=N_PRE){
+		adjList[u].push_back(v);
+		degree[u]++;
+	}
+	if(state[v]!=N_PRE){
+		adjList[v].push_back(u);
+		degree[v]++;
+	}
+}
+
+/*
+	Copy between two nodes
+*/
+void RegAllocator::addMove(int dst,int src)
+{
+	int m=moves.size();
+	moves.push_back(make_pair(dst,src));
+	moveState.push_back(M_WORK);
+	moveList[dst].push_back(m);
+	moveList[src].push_back(m);
+	workMoves.push_back(m);
+}
+
+/*
+	Neighbours neither selected nor coalesced
+*/
+vector<int>RegAllocator::adjacent(int n)
+{
+	vector<int>adj;
+	for(int i=0;i<adjList[n].size();i++){
+		int t=adjList[n][i];
+		if(state[t]!=N_STACK&&state[t]!=N_COALESCED)adj.push_back(t);
+	}
+	return adj;
+}
+
+/*
+	Moves of n not yet coalesced, constrained nor frozen
+*/
+vector<int>RegAllocator::nodeMoves(int n)
+{
+	vector<int>ms;
+	for(int i=0;i<moveList[n].size();i++)
+		if(moveState[moveList[n][i]]!=M_DONE)ms.push_back(moveList[n][i]);
+	return ms;
+}
+
+bool RegAllocator::moveRelated(int n)
+{
+	for(int i=0;i<moveList[n].size();i++)
+		if(moveState[moveList[n][i]]!=M_DONE)return true;
+	return false;
+}
+
+/*
+	Sort the referenced nodes by degree and moves
+*/
+void RegAllocator::makeWorklist()
+{
+	for(int n=1;n<state.size();n++){
+		if(ends[n-1]<0)state[n]=N_SPILLED;//only in unreachable code
+		else if(degree[n]>=REG_COUNT){
+			state[n]=N_SPILL;
+			spillWL.push_back(n);
+		}
+		else if(moveRelated(n)){
+			state[n]=N_FREEZE;
+			freezeWL.push_back(n);
+		}
+		else{
+			state[n]=N_SIMPLIFY;
+			simplifyWL.push_back(n);
+		}
+	}
+}
+
+/*
+	Next entry of a worklist still in its state, -1 if none
+*/
+int RegAllocator::take(vector<int>&wl,char st)
+{
+	while(!wl.empty()){
+		int n=wl.back();
+		wl.pop_back();
+		if(state[n]==st)return n;
+	}
+	return -1;
+}
+
+/*
+	Put a low degree node on the stack
+*/
+void RegAllocator::simplify(int n)
+{
+	state[n]=N_STACK;
+	selectStack.push_back(n);
+	vector<int>adj=adjacent(n);
+	for(int i=0;i<adj.size();i++)decrementDegree(adj[i]);
+}
+
+/*
+	A neighbour went away, at K-1 the node and its neighbours' moves may
+	coalesce and it leaves the spill worklist
+*/
+void RegAllocator::decrementDegree(int m)
+{
+	if(state[m]==N_PRE)return;
+	int d=degree[m]--;
+	if(d!=REG_COUNT)return;
+	enableMoves(m);
+	vector<int>adj=adjacent(m);
+	for(int i=0;i<adj.size();i++)enableMoves(adj[i]);
+	if(state[m]!=N_SPILL)return;
+	if(moveRelated(m)){
+		state[m]=N_FREEZE;
+		freezeWL.push_back(m);
+	}
+	else{
+		state[m]=N_SIMPLIFY;
+		simplifyWL.push_back(m);
+	}
+}
+
+/*
+	The delayed moves of n may be tried again
+*/
+void RegAllocator::enableMoves(int n)
+{
+	for(int i=0;i<moveList[n].size();i++){
+		int m=moveList[n][i];
+		if(moveState[m]==M_ACTIVE){
+			moveState[m]=M_WORK;
+			workMoves.push_back(m);
+		}
+	}
+}
+
+/*
+	Merge the ends of a move when the George or Briggs test allows it,
+	give up on interfering ends and delay the others
+*/
+void RegAllocator::coalesce(int m)
+{
+	int x=getAlias(moves[m].first),y=getAlias(moves[m].second);
+	int u=x,v=y;
+	if(state[y]==N_PRE){
+		u=y;
+		v=x;
+	}
+	moveState[m]=M_DONE;
+	if(u==v){
+		coalesced++;
+		addWorkList(u);
+		return;
+	}
+	if(state[v]==N_PRE||adjSet[u].get(v)){//constrained
+		addWorkList(u);
+		addWorkList(v);
+		return;
+	}
+	vector<int>adj=adjacent(v);
+	bool can;
+	if(state[u]==N_PRE){
+		can=true;
+		for(int i=0;i<adj.size()&&can;i++)can=ok(adj[i],u);
+	}
+	else{
+		vector<int>au=adjacent(u);
+		adj.insert(adj.end(),au.begin(),au.end());
+		sort(adj.begin(),adj.end());
+		adj.erase(unique(adj.begin(),adj.end()),adj.end());
+		can=conservative(adj);
+	}
+	if(can){
+		coalesced++;
+		combine(u,v);
+		addWorkList(u);
+	}
+	else moveState[m]=M_ACTIVE;
+}
+
+/*
+	A low degree node without moves can be simplified
+*/
+void RegAllocator::addWorkList(int u)
+{
+	if(state[u]==N_FREEZE&&!moveRelated(u)&&degree[u]<REG_COUNT){
+		state[u]=N_SIMPLIFY;
+		simplifyWL.push_back(u);
+	}
+}
+
+/*
+	George: neighbour t of v does not stop v from merging into r
+*/
+bool RegAllocator::ok(int t,int r)
+{
+	return degree[t]<REG_COUNT||state[t]==N_PRE||adjSet[t].get(r);
+}
+
+/*
+	Briggs: fewer than K significant neighbours
+*/
+bool RegAllocator::conservative(vector<int>&adj)
+{
+	int k=0;
+	for(int i=0;i<adj.size();i++)
+		if(degree[adj[i]]>=REG_COUNT)k++;
+	return k<REG_COUNT;
+}
+
+int RegAllocator::getAlias(int n)
+{
+	while(state[n]==N_COALESCED)n=alias[n];
+	return n;
+}
+
+/*
+	Merge v into u
+*/
+void RegAllocator::combine(int u,int v)
+{
+	state[v]=N_COALESCED;
+	alias[v]=u;
+	moveList[u].insert(moveList[u].end(),moveList[v].begin(),moveList[v].end());
+	enableMoves(v);
+	if(state[u]!=N_PRE&&cross[v-1])cross[u-1]=1;
+	vector<int>adj=adjacent(v);
+	for(int i=0;i<adj.size();i++){
+		addEdge(adj[i],u);
+		decrementDegree(adj[i]);
+	}
+	if(degree[u]>=REG_COUNT&&state[u]==N_FREEZE){
+		state[u]=N_SPILL;
+		spillWL.push_back(u);
+	}
+}
+
+/*
+	Give up the moves of a low degree node and simplify it
+*/
+void RegAllocator::freeze(int u)
+{
+	state[u]=N_SIMPLIFY;
+	simplifyWL.push_back(u);
+	freezeMoves(u);
+}
+
+void RegAllocator::freezeMoves(int u)
+{
+	vector<int>ms=nodeMoves(u);
+	for(int i=0;i<ms.size();i++){
+		int m=ms[i];
+		int x=getAlias(moves[m].first),y=getAlias(moves[m].second);
+		int v=(y==getAlias(u))?x:y;
+		moveState[m]=M_DONE;
+		if(state[v]==N_FREEZE&&!moveRelated(v)&&degree[v]<REG_COUNT){
+			state[v]=N_SIMPLIFY;
+			simplifyWL.push_back(v);
+		}
+	}
+}
+
+/*
+	Simplify the high degree node of the lowest cost per neighbour,
+	it may still get a color when selected
+*/
+void RegAllocator::selectSpill()
+{
+	int best=-1,keep=0;
+	for(int i=0;i<spillWL.size();i++){
+		int n=spillWL[i];
+		if(state[n]!=N_SPILL)continue;
+		spillWL[keep++]=n;
+		if(best<0||cost[n-1]*degree[best]<cost[best-1]*degree[n])best=n;
+	}
+	spillWL.resize(keep);
+	if(best<0)return;
+	state[best]=N_SIMPLIFY;
+	simplifyWL.push_back(best);
+	freezeMoves(best);
+}
+
+/*
+	Pop the stack and give every node a color its neighbours do not have,
+	the coalesced ones take the color of their alias
+*/
+void RegAllocator::assignColors()
+{
+	while(!selectStack.empty()){
+		int n=selectStack.back();
+		selectStack.pop_back();
+		int busy=0;
+		for(int i=0;i<adjList[n].size();i++){
+			int a=getAlias(adjList[n][i]);
+			if(state[a]==N_COLORED||state[a]==N_PRE)busy|=1<<color[a];
+		}
+		int reg=pick(n-1,busy);
+		if(reg<0)state[n]=N_SPILLED;
+		else{
+			state[n]=N_COLORED;
+			color[n]=reg;
+			used|=1<<reg;
+		}
+	}
+	for(int n=1;n<state.size();n++){
+		int a=getAlias(n);
+		if(state[a]==N_COLORED)nodes[n-1]->regId=color[a];
+	}
+}
+
+/*
+	Iterated register coalescing over the graph built by scan
+*/
+void RegAllocator::colorGraph()
+{
+	makeWorklist();
+	while(true){
+		int n;
+		if((n=take(simplifyWL,N_SIMPLIFY))>=0)simplify(n);
+		else if(!workMoves.empty()){
+			int m=workMoves.back();
+			workMoves.pop_back();
+			if(moveState[m]==M_WORK)coalesce(m);
+		}
+		else if((n=take(freezeWL,N_FREEZE))>=0)freeze(n);
+		else if(!spillWL.empty())selectSpill();
+		else break;
+	}
+	assignColors();
+}
+
+/*
+	Linear scan at -O1, coloring at -O2 or as chosen by --regalloc, large
+	functions are scanned and functions whose liveness is over the budget
+	keep everything in memory
+*/
+void RegAllocator::allocate()
+{
+	int kind=Args::regAlloc>=0?Args::regAlloc:(Args::opt>=2?ALLOC_COLOR:Args::opt?ALLOC_LINEAR:ALLOC_NONE);
+	if(kind==ALLOC_NONE||fun->getExtern()||code.empty())return;
+	DFG dfg(fun->getInterCode());
+	LiveVar live(&dfg,code);
+	if(live.isLocal())return;
+	vars=&live.getVars();
+	collect();
+	if(nodes.empty())return;
+	bool graph=kind==ALLOC_COLOR&&nodes.size()<=COLOR_NODES;
+	if(graph){
+		int n=nodes.size()+1;
+		adjSet.assign(n,Set(n,false));
+		adjList.assign(n,vector<int>());
+		degree.assign(n,0);
+		alias.resize(n);
+		for(int i=0;i<n;i++)alias[i]=i;
+		color.assign(n,-1);
+		state.assign(n,N_SIMPLIFY);
+		moveList.assign(n,vector<int>());
+		state[0]=N_PRE;
+		color[0]=REG_ECX;
+		degree[0]=INT_MAX/2;
+	}
+	scan(dfg,live,graph);
+	if(graph)colorGraph();
+	else linearScan();
+	vector<int>saved;
+	for(int k=0;k<REG_ECX;k++)
+		if(used>>k&1)saved.push_back(k);
+	fun->setSaved(saved);
+	if(Args::stats){
+		int refs=0,regs=0;
+		for(int c=0;c<nodes.size();c++){
+			if(ends[c]>=0)refs++;
+			if(nodes[c]->regId>=0)regs++;
+		}
+		fprintf(stderr,"%s: %s, %d of %d candidates in registers, %d copies coalesced, %d saved\n",
+			fun->getName().c_str(),graph?"coloring":"linear scan",regs,refs,coalesced,(int)saved.size());
+	}
+}
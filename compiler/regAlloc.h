@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common.h"
+#include "set.h"
+
+class Fun;
+class Var;
+class InterInst;
+class DFG;
+class LiveVar;
+class VarIndex;
+
+#define REG_COUNT 4//allocatable registers: ebx, esi, edi, ecx
+#define REG_ECX 3//the only caller saved one, the others are saved in the frame
+#define COLOR_NODES 2000//candidates above which coloring gives way to linear scan
+#define LOOP_WEIGHT 10//spill cost factor of every loop level
+#define ALLOC_NONE 0//Args::regAlloc choices
+#define ALLOC_LINEAR 1
+#define ALLOC_COLOR 2
+
+/*
+	Register allocation of the scalar locals and temporaries of a function.
+	eax and edx stay free as scratch registers of the code generator, ebx,
+	esi and edi are callee saved and stored in the frame by the prologue
+	when used, ecx is clobbered by calls, divisions and shifts and only
+	holds values that are not live across them. Arrays, chars and address
+	taken variables stay in memory, so a spilled value needs no rewrite:
+	it simply keeps its stack slot.
+	Linear scan walks the live intervals in order of their start, iterated
+	register coalescing (George and Appel) colors the interference graph
+	and merges the copies between candidates. Both spill the lowest cost,
+	the references weighted by LOOP_WEIGHT per loop level.
+*/
+class RegAllocator
+{
+	enum{M_WORK,M_ACTIVE,M_DONE};//move states
+	enum{N_PRE,N_SIMPLIFY,N_FREEZE,N_SPILL,N_COALESCED,N_STACK,N_COLORED,N_SPILLED};//node states
+
+	Fun*fun;
+	vector<InterInst*>&code;
+	VarIndex*vars;//numbering of the liveness
+	vector<Var*>nodes;//candidates
+	vector<int>nodeOf;//candidate of every variable index, -1 if none
+	Set cands;//candidate variable indexes
+	vector<double>cost;//spill cost
+	vector<char>cross;//live across an instruction that clobbers ecx
+	vector<int>starts,ends;//live interval hull, instruction i reads at 2i and writes at 2i+1
+	vector<int>clobbers;//positions of the instructions that clobber ecx
+	int used;//registers handed out, one bit each
+	int coalesced;//copies merged
+
+	//iterated coalescing, node 0 is ecx and candidate c is node c+1
+	vector<Set>adjSet;//interference matrix
+	vector<vector<int> >adjList;//neighbours of the candidates
+	vector<int>degree,alias,color;
+	vector<char>state;//node states
+	vector<vector<int> >moveList;//moves of every node
+	vector<pair<int,int> >moves;//dst and src nodes
+	vector<char>moveState;
+	vector<int>simplifyWL,freezeWL,spillWL,workMoves,selectStack;//worklists, stale entries skipped
+
+	bool clobbersEcx(InterInst*inst);//calls, divisions and variable shifts
+	int candidate(Var*var);//candidate of a variable, -1 if none
+	void collect();//the candidates
+	void scan(DFG&dfg,LiveVar&live,bool graph);//costs, intervals and, for coloring, the graph
+	void extend(int c,int point);//grow the interval of c
+	int pick(int c,int busy);//free register for c, -1 if none
+	void linearScan();//allocate in order of the interval starts
+
+	void addEdge(int u,int v);
+	void addMove(int dst,int src);
+	vector<int>adjacent(int n);//neighbours still in the graph
+	vector<int>nodeMoves(int n);//moves not yet settled
+	bool moveRelated(int n);
+	void makeWorklist();
+	int take(vector<int>&wl,char st);//next entry still in state st, -1 if none
+	void simplify(int n);
+	void decrementDegree(int m);
+	void enableMoves(int n);
+	void coalesce(int m);
+	void addWorkList(int u);
+	bool ok(int t,int r);//George test
+	bool conservative(vector<int>&adj);//Briggs test
+	int getAlias(int n);
+	void combine(int u,int v);
+	void freeze(int u);
+	void freezeMoves(int u);
+	void selectSpill();
+	void assignColors();
+	void colorGraph();//iterated register coalescing
+public:
+	RegAllocator(Fun*fun);
+
+	void allocate();//choose the allocator of the level, sets Var::regId and the saved registers
+	static const char*name(int reg);//register name
+};
@@ -32,6 +32,9 @@ namespace Compiler
 Scanner::Scanner(string srcFile)
     :
     m_srcFile(srcFile),
+    m_pSrcHandle(NULL),
+    m_pOutHandle(NULL),
+    m_pIrHandle(NULL),
     m_bufferLength(0),
     m_readPosition(-1),
     m_line(1),
@@ -58,7 +61,7 @@ Scanner::Scanner(string srcFile)
 }
 
 // =====================================================================================================================
-void Scanner::Init()
+void Scanner::Init(bool openIr, bool openAsm)
 {
     printf("%s\n", m_srcFile.c_str());
     m_pSrcHandle = fopen(m_srcFile.c_str(), "r");
@@ -73,17 +76,27 @@ void Scanner::Init()
 
     string asmFile = "../out/" + m_srcFile.substr(fileNameStart, fileNameEnd - fileNameStart) + ".s";
     string irFile = "../out/" + m_srcFile.substr(fileNameStart, fileNameEnd - fileNameStart) + ".ir";
-    m_pOutHandle = fopen(asmFile.c_str(), "w");
-    m_pIrHandle = fopen(irFile.c_str(), "w");
+    // only create the outputs that were asked for
+    m_pOutHandle = openAsm ? fopen(asmFile.c_str(), "w") : NULL;
+    m_pIrHandle = openIr ? fopen(irFile.c_str(), "w") : NULL;
 }
 
 // =====================================================================================================================
 void Scanner::Destroy()
 {
     printf("%s\n", m_srcFile.c_str());
-    fclose(m_pSrcHandle);
-    fclose(m_pOutHandle);
-    fclose(m_pIrHandle);
+    if (m_pSrcHandle)
+    {
+        fclose(m_pSrcHandle);
+    }
+    if (m_pOutHandle)
+    {
+        fclose(m_pOutHandle);
+    }
+    if (m_pIrHandle)
+    {
+        fclose(m_pIrHandle);
+    }
 }
 
 // =====================================================================================================================
@@ -109,12 +122,8 @@ char Scanner::ScanFile(FILE *pSrcFile)
 
     char element = m_pBuffer[m_readPosition];
 
-    if (element == -1)
-    {
-        fclose(pSrcFile);
-        pSrcFile = NULL;
-    }
-    else if (element != '\n')
+    // source stays open at end of file, it is closed in Destroy()
+    if ((element != -1) && (element != '\n'))
     {
         m_column++;
     }
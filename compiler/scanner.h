@@ -46,7 +46,7 @@ public:
     Scanner(string srcFile);
     ~Scanner() { Destroy(); }
 
-    void Init();
+    void Init(bool openIr = true, bool openAsm = true);
     void Destroy();
 
     char ScanFile(FILE *pSrcFile);
@@ -729,7 +729,6 @@ void SemanticAnalyzer::SwitchStatement()
 {
 	m_symbolTable.Enter();
 	InterInst* _exit;
-	m_ir.GenSwitchHead(_exit);
 	Match(KW_SWITCH);
 	if(!Match(LPAREN))
     {
@@ -740,6 +739,7 @@ void SemanticAnalyzer::SwitchStatement()
     {
         cond = m_ir.GenAssign(cond);//switch(*p),switch(a[0])
     }
+	m_ir.GenSwitchHead(cond, _exit);
 	if(!Match(RPAREN))
     {
 		Recovery(m_look->tag == LBRACE, RPAREN_LOST, RPAREN_WRONG);
@@ -748,7 +748,7 @@ void SemanticAnalyzer::SwitchStatement()
     {
 		Recovery((m_look->tag == KW_CASE) || (m_look->tag == KW_DEFAULT), LBRACE_LOST, LBRACE_WRONG);
     }
-	CaseStatement(cond);
+	CaseStatement();
 	if(!Match(RBRACE))
     {
 		Recovery(IsType() || IsStatement(), RBRACE_LOST, RBRACE_WRONG);
@@ -760,12 +760,11 @@ void SemanticAnalyzer::SwitchStatement()
 // =====================================================================================================================
 //	<casestat> 		-> 	rsv_case <CaseLabel> colon <SubProgram><casestat>
 //										|rsv_default colon <SubProgram>
-void SemanticAnalyzer::CaseStatement(Var*cond)
+void SemanticAnalyzer::CaseStatement()
 {
 	if(Match(KW_CASE)){
-		InterInst*  _case_exit;
 		Var* lb= CaseLabel();
-		m_ir.GenCaseHead(cond, lb, _case_exit);
+		m_ir.GenCaseHead(lb);
 		if(!Match(COLON))
         {
 			Recovery(IsType() || IsStatement(), COLON_LOST, COLON_WRONG);
@@ -773,8 +772,7 @@ void SemanticAnalyzer::CaseStatement(Var*cond)
 		m_symbolTable.Enter();
 		SubProgram();
 		m_symbolTable.Leave();
-		m_ir.GenCaseTail(_case_exit);//case尾部
-		CaseStatement(cond);
+		CaseStatement();
 	}
 	else if(Match(KW_DEFAULT))
     {
@@ -782,6 +780,7 @@ void SemanticAnalyzer::CaseStatement(Var*cond)
         {
 			Recovery(IsType() || IsStatement(), COLON_LOST, COLON_WRONG);
         }
+		m_ir.GenDefaultHead();
 		m_symbolTable.Enter();
 		SubProgram();
 		m_symbolTable.Leave();
@@ -845,8 +844,9 @@ Var* SemanticAnalyzer::OrExpr()
 Var* SemanticAnalyzer::OrTail(Var* lval)
 {
 	if(Match(OR)){
+		m_ir.GenOrHead(lval);//左部为真时跳过右部
 		Var* rval = AndExpr();
-		Var* result = m_ir.GenTwoOp(lval, OR, rval);
+		Var* result = m_ir.GenOrTail(rval);
 		return OrTail(result);
 	}
 	return lval;
@@ -866,8 +866,9 @@ Var* SemanticAnalyzer::AndTail(Var*lval)
 {
 	if(Match(AND))
     {
+		m_ir.GenAndHead(lval);//左部为假时跳过右部
 		Var* rval = CmpExpr();
-		Var* result = m_ir.GenTwoOp(lval, AND, rval);
+		Var* result = m_ir.GenAndTail(rval);
 		return AndTail(result);
 	}
 	return lval;
@@ -69,7 +69,7 @@ private:
 	void IfStatement();
 	void ElseStatement();
 	void SwitchStatement();
-	void CaseStatement(Var* cond);
+	void CaseStatement();
 	Var* CaseLabel();
 	
 	// expression grammar
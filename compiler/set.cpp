@@ -0,0 +1,215 @@
+#include "set.h"
+
+Set::Set():count(0)
+{
+}
+
+Set::Set(int size,bool val)
+{
+	init(size,val);
+}
+
+/*
+	Resize and fill
+*/
+void Set::init(int size,bool val)
+{
+	count=size;
+	words.assign((size+63)/64,val?~(uint64_t)0:0);
+	trim();
+}
+
+/*
+	Clear the bits past count so whole word compares and counts stay exact
+*/
+void Set::trim()
+{
+	if(count%64)words.back()&=((uint64_t)1<<(count%64))-1;
+}
+
+/*
+	Number of bits
+*/
+int Set::size() const
+{
+	return count;
+}
+
+/*
+	Set bit i
+*/
+void Set::set(int i)
+{
+	words[i>>6]|=(uint64_t)1<<(i&63);
+}
+
+/*
+	Clear bit i
+*/
+void Set::reset(int i)
+{
+	words[i>>6]&=~((uint64_t)1<<(i&63));
+}
+
+/*
+	Test bit i
+*/
+bool Set::get(int i) const
+{
+	return (words[i>>6]>>(i&63))&1;
+}
+
+/*
+	Set or clear all bits
+*/
+void Set::fill(bool val)
+{
+	init(count,val);
+}
+
+/*
+	No bit set
+*/
+bool Set::empty() const
+{
+	uint64_t any=0;
+	for(size_t i=0;i<words.size();i++)any|=words[i];
+	return !any;
+}
+
+/*
+	Number of set bits
+*/
+int Set::ones() const
+{
+	int n=0;
+	for(size_t i=0;i<words.size();i++)n+=__builtin_popcountll(words[i]);
+	return n;
+}
+
+/*
+	First set bit at or after i, -1 if none
+*/
+int Set::next(int i) const
+{
+	if(i>=count)return -1;
+	size_t w=i>>6;
+	uint64_t bits=words[w]&(~(uint64_t)0<<(i&63));
+	while(!bits){
+		if(++w>=words.size())return -1;
+		bits=words[w];
+	}
+	return w*64+__builtin_ctzll(bits);
+}
+
+/*
+	this|=s, true if changed
+*/
+bool Set::unite(const Set& s)
+{
+	uint64_t diff=0;
+	uint64_t* a=words.data();
+	const uint64_t* b=s.words.data();
+	for(size_t i=0,n=words.size();i<n;i++){
+		uint64_t v=a[i]|b[i];
+		diff|=v^a[i];
+		a[i]=v;
+	}
+	return diff!=0;
+}
+
+/*
+	this&=s, true if changed
+*/
+bool Set::intersect(const Set& s)
+{
+	uint64_t diff=0;
+	uint64_t* a=words.data();
+	const uint64_t* b=s.words.data();
+	for(size_t i=0,n=words.size();i<n;i++){
+		uint64_t v=a[i]&b[i];
+		diff|=v^a[i];
+		a[i]=v;
+	}
+	return diff!=0;
+}
+
+/*
+	this&=~s
+*/
+void Set::subtract(const Set& s)
+{
+	uint64_t* a=words.data();
+	const uint64_t* b=s.words.data();
+	for(size_t i=0,n=words.size();i<n;i++)
+		a[i]&=~b[i];
+}
+
+/*
+	Dataflow transfer function: this=gen|(in&~kill), true if changed
+*/
+bool Set::transfer(const Set& gen,const Set& in,const Set& kill)
+{
+	uint64_t diff=0;
+	uint64_t* a=words.data();
+	const uint64_t* g=gen.words.data();
+	const uint64_t* x=in.words.data();
+	const uint64_t* k=kill.words.data();
+	for(size_t i=0,n=words.size();i<n;i++){
+		uint64_t v=g[i]|(x[i]&~k[i]);
+		diff|=v^a[i];
+		a[i]=v;
+	}
+	return diff!=0;
+}
+
+/*
+	Union
+*/
+Set Set::operator|(const Set& s) const
+{
+	Set r=*this;
+	r.unite(s);
+	return r;
+}
+
+/*
+	Intersection
+*/
+Set Set::operator&(const Set& s) const
+{
+	Set r=*this;
+	r.intersect(s);
+	return r;
+}
+
+/*
+	Difference
+*/
+Set Set::operator-(const Set& s) const
+{
+	Set r=*this;
+	r.subtract(s);
+	return r;
+}
+
+/*
+	Complement
+*/
+Set Set::operator~() const
+{
+	Set r=*this;
+	for(size_t i=0;i<r.words.size();i++)r.words[i]=~r.words[i];
+	r.trim();
+	return r;
+}
+
+bool Set::operator==(const Set& s) const
+{
+	return count==s.count&&words==s.words;
+}
+
+bool Set::operator!=(const Set& s) const
+{
+	return !(*this==s);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include "common.h"
+
+/*
+	Dense bit set. Bits live in contiguous 64 bit words and every set
+	operation is a branch free loop over the words, so the compiler can
+	vectorise unions and intersections.
+*/
+class Set
+{
+	vector<uint64_t> words;//bit storage, unused high bits of the last word stay 0
+	int count;//number of bits
+
+	void trim();//clear the bits past count
+public:
+	Set();
+	Set(int size,bool val=false);
+
+	void init(int size,bool val);//resize and fill
+	int size() const;//number of bits
+	void set(int i);//set bit i
+	void reset(int i);//clear bit i
+	bool get(int i) const;//test bit i
+	void fill(bool val);//set or clear all bits
+	bool empty() const;//no bit set
+	int ones() const;//number of set bits
+	int next(int i) const;//first set bit at or after i, -1 if none
+
+	bool unite(const Set& s);//this|=s, true if changed
+	bool intersect(const Set& s);//this&=s, true if changed
+	void subtract(const Set& s);//this&=~s
+	bool transfer(const Set& gen,const Set& in,const Set& kill);//this=gen|(in&~kill), true if changed
+
+	Set operator|(const Set& s) const;//union
+	Set operator&(const Set& s) const;//intersection
+	Set operator-(const Set& s) const;//difference
+	Set operator~() const;//complement
+	bool operator==(const Set& s) const;
+	bool operator!=(const Set& s) const;
+};
@@ -0,0 +1,780 @@
+#include "ssa.h"
+#include "dfg.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <algorithm>
+#include <unordered_set>
+#include <climits>
+
+SSA::SSA(Fun*fun,SymTab*tab):fun(fun),tab(tab),dfg(NULL)
+{
+	phiCount=copies=coalesced=classes=0;
+}
+
+SSA::~SSA()
+{
+	for(int i=0;i<phis.size();i++)
+		for(int j=0;j<phis[i].size();j++)
+			delete phis[i][j];
+	//versions that did not become the variable of a class
+	for(int i=0;i<vers.size();i++)
+		if(vers[i].owned)delete vers[i].var;
+	delete dfg;
+}
+
+/*
+	Scalar local, parameter or temporary whose address is never taken
+*/
+bool SSA::candidate(Var*v)
+{
+	return v&&v->notConst()&&!v->isVoid()&&!v->getExtern()&&v->getPath().size()>1
+		&&!v->getArray()&&!v->inMem&&(v->unInit()||v->isBase());
+}
+
+/*
+	Literal variable
+*/
+Var* SSA::literal(int val)
+{
+	unordered_map<int,Var*>::iterator it=literals.find(val);
+	if(it!=literals.end())return it->second;
+	Var*lit=new Var(val);
+	tab->AddVar(lit);
+	literals[val]=lit;
+	return lit;
+}
+
+/*
+	Index of a version, -1 for other variables
+*/
+int SSA::version(Var*v)
+{
+	if(!v||v->index<0||v->index>=vers.size()||vers[v->index].var!=v)return -1;
+	return v->index;
+}
+
+/*
+	New version of variable k
+*/
+int SSA::newVersion(int k)
+{
+	Version ver;
+	ver.var=new Var(vars[k]->getPath(),vars[k]);
+	ver.origin=k;
+	ver.def=NULL;
+	ver.phi=NULL;
+	ver.block=NULL;
+	ver.pos=0;
+	ver.parent=vers.size();
+	ver.owned=true;
+	ver.var->index=vers.size();
+	vers.push_back(ver);
+	return vers.size()-1;
+}
+
+/*
+	Collect the variables to rename, their entry values are the first versions
+*/
+void SSA::findVars()
+{
+	vector<InterInst*>&code=fun->getCode();
+	unordered_set<Var*>addressed;
+	for(int i=0;i<code.size();i++)
+		if(!code[i]->isLb()&&code[i]->getOp()==OP_LEA)addressed.insert(code[i]->getArg1());
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		Var*refs[3];
+		int n=inst->getUses(refs);
+		if(inst->getDef())refs[n++]=inst->getDef();
+		else if(!inst->isLb()&&inst->getOp()==OP_DEC)refs[n++]=inst->getArg1();
+		for(int j=0;j<n;j++){
+			Var*v=refs[j];
+			if(!candidate(v)||addressed.count(v)||version(v)>=0)continue;
+			Version ver;
+			ver.var=v;
+			ver.origin=vars.size();
+			ver.def=NULL;
+			ver.phi=NULL;
+			ver.block=NULL;
+			ver.pos=-2;
+			ver.parent=vars.size();
+			ver.owned=false;
+			v->index=vars.size();
+			vers.push_back(ver);
+			vars.push_back(v);
+		}
+	}
+}
+
+/*
+	Phi functions on the iterated dominance frontiers of the definitions.
+	Only variables read in some block before being written there can be
+	live across blocks and need them (semi-pruned form).
+*/
+void SSA::placePhis()
+{
+	vector<Block*>&blocks=dfg->getBlocks();
+	vector<Block*>&order=dfg->getOrder();
+	int nb=blocks.size(),nv=vars.size();
+	//dominance frontiers: walk up from the predecessors of every join
+	vector<vector<Block*> >frontier(nb);
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		if(b->prevs.size()<2)continue;
+		for(int j=0;j<b->prevs.size();j++){
+			Block*p=b->prevs[j];
+			if(!p->reachable())continue;
+			for(Block*r=p;r!=b->idom;r=r->idom){
+				vector<Block*>&df=frontier[r->id];
+				if(!df.empty()&&df.back()==b)break;//the rest of the chain has it too
+				df.push_back(b);
+			}
+		}
+	}
+	//variables live across blocks and the blocks defining them
+	vector<bool>global(nv,false);
+	vector<vector<Block*> >defBlocks(nv);
+	vector<int>written(nv,-1);//last block writing the variable
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			Var*uses[2];
+			int n=inst->getUses(uses);
+			for(int u=0;u<n;u++){
+				int k=version(uses[u]);
+				if(k>=0&&written[k]!=b->id)global[k]=true;
+			}
+			int k=version(inst->getDef());
+			if(k<0)continue;
+			if(written[k]!=b->id)defBlocks[k].push_back(b);
+			written[k]=b->id;
+		}
+	}
+	//iterated frontiers
+	vector<int>hasPhi(nb,-1),queued(nb,-1);
+	vector<Block*>work;
+	for(int k=0;k<nv;k++){
+		if(!global[k])continue;
+		work=defBlocks[k];
+		for(int i=0;i<work.size();i++)queued[work[i]->id]=k;
+		while(!work.empty()){
+			Block*x=work.back();
+			work.pop_back();
+			vector<Block*>&df=frontier[x->id];
+			for(int i=0;i<df.size();i++){
+				Block*y=df[i];
+				if(hasPhi[y->id]==k)continue;
+				hasPhi[y->id]=k;
+				Phi*phi=new Phi;
+				phi->var=vars[k];
+				phi->result=NULL;
+				phi->args.assign(y->prevs.size(),NULL);
+				phis[y->id].push_back(phi);
+				if(queued[y->id]!=k){
+					queued[y->id]=k;
+					work.push_back(y);
+				}
+			}
+		}
+	}
+}
+
+/*
+	Give every definition a new version walking the dominator tree with a
+	stack of current versions per variable. Initialised declarations become
+	copies of their initial value, the other declarations are dropped.
+*/
+void SSA::rename()
+{
+	int nv=vars.size();
+	vector<vector<int> >current(nv);//version stack per variable, empty means the entry value
+	vector<int>pushed;//variables pushed, popped when leaving the block
+	vector<pair<Block*,int> >stack;//block and the pushed mark, -1 before it is entered
+	stack.push_back(make_pair(dfg->getEntry(),-1));
+	while(!stack.empty()){
+		Block*b=stack.back().first;
+		int mark=stack.back().second;
+		if(mark>=0){
+			while(pushed.size()>mark){
+				current[pushed.back()].pop_back();
+				pushed.pop_back();
+			}
+			stack.pop_back();
+			continue;
+		}
+		stack.back().second=pushed.size();
+		vector<Phi*>&bp=phis[b->id];
+		for(int i=0;i<bp.size();i++){
+			int k=version(bp[i]->var);
+			int v=newVersion(k);
+			bp[i]->result=vers[v].var;
+			current[k].push_back(v);
+			pushed.push_back(k);
+		}
+		for(int i=0;i<b->insts.size();i++){
+			InterInst*inst=b->insts[i];
+			if(inst->isLb())continue;
+			if(inst->getOp()==OP_DEC){
+				Var*var=inst->getArg1();
+				int k=version(var);
+				if(k<0)continue;
+				if(var->unInit()){
+					inst->isDead=true;
+					continue;
+				}
+				int v=newVersion(k);
+				inst->replace(OP_AS,vers[v].var,literal(var->getVal()));
+				current[k].push_back(v);
+				pushed.push_back(k);
+				continue;
+			}
+			Var*uses[2];
+			int n=inst->getUses(uses);
+			for(int u=0;u<n;u++){
+				int k=version(uses[u]);
+				if(k<0)continue;
+				int v=current[k].empty()?k:current[k].back();
+				inst->replaceUse(uses[u],vers[v].var);
+			}
+			int k=version(inst->getDef());
+			if(k<0)continue;
+			int v=newVersion(k);
+			inst->setResult(vers[v].var);
+			current[k].push_back(v);
+			pushed.push_back(k);
+		}
+		for(int i=0;i<b->succs.size();i++){
+			Block*s=b->succs[i];
+			int j=std::find(s->prevs.begin(),s->prevs.end(),b)-s->prevs.begin();
+			vector<Phi*>&sp=phis[s->id];
+			for(int p=0;p<sp.size();p++){
+				int k=version(sp[p]->var);
+				sp[p]->args[j]=vers[current[k].empty()?k:current[k].back()].var;
+			}
+		}
+		for(int i=0;i<b->domKids.size();i++)
+			stack.push_back(make_pair(b->domKids[i],-1));
+	}
+	//declarations left in unreachable blocks
+	vector<InterInst*>&code=fun->getCode();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(!inst->isLb()&&inst->getOp()==OP_DEC&&version(inst->getArg1())>=0)
+			inst->isDead=true;
+	}
+}
+
+/*
+	Remove phi functions whose result is never read, which may leave
+	others without uses
+*/
+void SSA::prunePhis()
+{
+	vector<int>count(vers.size(),0);
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int j=0;j<b->insts.size();j++){
+			Var*uses[2];
+			int n=b->insts[j]->getUses(uses);
+			for(int u=0;u<n;u++){
+				int v=version(uses[u]);
+				if(v>=0)count[v]++;
+			}
+		}
+		vector<Phi*>&bp=phis[b->id];
+		for(int j=0;j<bp.size();j++){
+			vers[version(bp[j]->result)].phi=bp[j];
+			for(int a=0;a<bp[j]->args.size();a++)
+				if(bp[j]->args[a])count[version(bp[j]->args[a])]++;
+		}
+	}
+	vector<Phi*>work;
+	for(int i=0;i<order.size();i++){
+		vector<Phi*>&bp=phis[order[i]->id];
+		for(int j=0;j<bp.size();j++)
+			if(!count[version(bp[j]->result)])work.push_back(bp[j]);
+	}
+	unordered_set<Phi*>dead;
+	while(!work.empty()){
+		Phi*phi=work.back();
+		work.pop_back();
+		dead.insert(phi);
+		for(int a=0;a<phi->args.size();a++){
+			if(!phi->args[a])continue;
+			int v=version(phi->args[a]);
+			if(--count[v]==0&&vers[v].phi&&!dead.count(vers[v].phi))work.push_back(vers[v].phi);
+		}
+	}
+	for(int i=0;i<phis.size();i++){
+		vector<Phi*>&bp=phis[i];
+		int keep=0;
+		for(int j=0;j<bp.size();j++){
+			if(dead.count(bp[j])){
+				vers[version(bp[j]->result)].phi=NULL;
+				delete bp[j];
+			}
+			else bp[keep++]=bp[j];
+		}
+		bp.resize(keep);
+		phiCount+=keep;
+	}
+}
+
+/*
+	Definitions and uses of the versions from the current code
+*/
+void SSA::collect()
+{
+	for(int i=0;i<vers.size();i++){
+		Version&ver=vers[i];
+		ver.def=NULL;
+		ver.phi=NULL;
+		ver.block=i<vars.size()?dfg->getEntry():NULL;
+		ver.pos=i<vars.size()?-2:0;
+		ver.uses.clear();
+		ver.at.clear();
+		ver.phiUses.clear();
+	}
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		vector<Phi*>&bp=phis[b->id];
+		for(int j=0;j<bp.size();j++){
+			Version&ver=vers[version(bp[j]->result)];
+			ver.phi=bp[j];
+			ver.block=b;
+			ver.pos=-1;
+			for(int a=0;a<bp[j]->args.size();a++)
+				if(bp[j]->args[a])vers[version(bp[j]->args[a])].phiUses.push_back(b->prevs[a]);
+		}
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isDead)continue;
+			Var*uses[2];
+			int n=inst->getUses(uses);
+			for(int u=0;u<n;u++){
+				int v=version(uses[u]);
+				if(v<0||(u&&uses[u]==uses[0]))continue;
+				vers[v].uses.push_back(inst);
+				vers[v].at.push_back(make_pair(b->id,j));
+			}
+			int v=version(inst->getDef());
+			if(v<0)continue;
+			vers[v].def=inst;
+			vers[v].block=b;
+			vers[v].pos=j;
+		}
+	}
+	for(int i=0;i<vers.size();i++)
+		sort(vers[i].at.begin(),vers[i].at.end());
+}
+
+/*
+	Convert to SSA form
+*/
+void SSA::build()
+{
+	dfg=new DFG(fun->getInterCode());
+	if(dfg->markUnreachable()){
+		//unreachable code would keep the old names
+		fun->getInterCode().removeDead();
+		delete dfg;
+		dfg=new DFG(fun->getInterCode());
+	}
+	phis.assign(dfg->getBlocks().size(),vector<Phi*>());
+	findVars();
+	if(vars.empty())return;
+	placePhis();
+	rename();
+	prunePhis();
+	collect();
+}
+
+/*
+	Isolate every phi function: the predecessors copy their operand into a
+	new version at their end, before the branch, and the head of the block
+	copies the new phi result into the old one. The phi and its operands
+	then form a web that cannot interfere with anything.
+*/
+void SSA::isolate()
+{
+	vector<Block*>&blocks=dfg->getBlocks();
+	vector<vector<InterInst*> >head(blocks.size()),tail(blocks.size());
+	for(int i=0;i<blocks.size();i++){
+		Block*b=blocks[i];
+		vector<Phi*>&bp=phis[b->id];
+		for(int j=0;j<bp.size();j++){
+			Phi*phi=bp[j];
+			int k=version(phi->var);
+			int r=newVersion(k);
+			head[b->id].push_back(new InterInst(OP_AS,phi->result,vers[r].var));
+			phi->result=vers[r].var;
+			for(int a=0;a<phi->args.size();a++){
+				if(!phi->args[a])continue;
+				int v=newVersion(k);
+				tail[b->prevs[a]->id].push_back(new InterInst(OP_AS,vers[v].var,phi->args[a]));
+				phi->args[a]=vers[v].var;
+			}
+		}
+	}
+	//splice the copies into the blocks and the code
+	vector<InterInst*>&code=fun->getCode();
+	code.clear();
+	for(int i=0;i<blocks.size();i++){
+		Block*b=blocks[i];
+		vector<InterInst*>insts;
+		int j=0;
+		if(!b->insts.empty()&&b->insts[0]->isLb())insts.push_back(b->insts[j++]);
+		insts.insert(insts.end(),head[i].begin(),head[i].end());
+		int last=b->insts.size();
+		if(last>j&&(b->insts[last-1]->isJmp()||b->insts[last-1]->isJcond()))last--;
+		insts.insert(insts.end(),b->insts.begin()+j,b->insts.begin()+last);
+		insts.insert(insts.end(),tail[i].begin(),tail[i].end());
+		insts.insert(insts.end(),b->insts.begin()+last,b->insts.end());
+		copies+=head[i].size()+tail[i].size();
+		for(int k=0;k<insts.size();k++)insts[k]->block=b;
+		b->insts.swap(insts);
+		code.insert(code.end(),b->insts.begin(),b->insts.end());
+	}
+}
+
+/*
+	Blocks where each version is live at the end, found by walking
+	backwards from its uses to its definition. Versions are visited in
+	order, so the sets come out sorted.
+*/
+void SSA::computeLiveOut()
+{
+	int nb=dfg->getBlocks().size();
+	liveOut.assign(nb,vector<int>());
+	vector<int>inMark(nb,-1),outMark(nb,-1);
+	vector<Block*>work;
+	for(int v=0;v<vers.size();v++){
+		Version&ver=vers[v];
+		if(!ver.block)continue;
+		Block*d=ver.block;
+		for(int i=0;i<ver.uses.size();i++){
+			Block*b=ver.uses[i]->block;
+			if(b==d||inMark[b->id]==v)continue;//uses in the defining block follow the definition
+			inMark[b->id]=v;
+			work.push_back(b);
+		}
+		for(int i=0;i<ver.phiUses.size();i++){
+			Block*b=ver.phiUses[i];
+			if(outMark[b->id]!=v){
+				outMark[b->id]=v;
+				liveOut[b->id].push_back(v);
+			}
+			if(b==d||inMark[b->id]==v)continue;
+			inMark[b->id]=v;
+			work.push_back(b);
+		}
+		while(!work.empty()){
+			Block*b=work.back();
+			work.pop_back();
+			for(int i=0;i<b->prevs.size();i++){
+				Block*p=b->prevs[i];
+				if(!p->reachable())continue;
+				if(outMark[p->id]!=v){
+					outMark[p->id]=v;
+					liveOut[p->id].push_back(v);
+				}
+				if(p==d||inMark[p->id]==v)continue;
+				inMark[p->id]=v;
+				work.push_back(p);
+			}
+		}
+	}
+}
+
+/*
+	Place of the definition in dominator tree preorder. The blocks
+	dominated by a block are numbered between its pre and post numbers.
+*/
+long long SSA::key(int v)
+{
+	return ((long long)vers[v].block->domPre<<32)+vers[v].pos+2;
+}
+
+/*
+	First key after the definitions dominated by v
+*/
+long long SSA::end(int v)
+{
+	return (long long)vers[v].block->domPost<<32;
+}
+
+/*
+	Definition of a dominates that of b
+*/
+bool SSA::dominates(int a,int b)
+{
+	Version&x=vers[a];
+	Version&y=vers[b];
+	if(x.block==y.block)return x.pos<=y.pos;
+	return dfg->dominates(x.block,y.block);
+}
+
+/*
+	a is live just after the definition of b, a's definition dominating it
+*/
+bool SSA::liveAt(int a,int b)
+{
+	Block*d=vers[b].block;
+	vector<int>&out=liveOut[d->id];
+	if(binary_search(out.begin(),out.end(),a))return true;
+	vector<pair<int,int> >&at=vers[a].at;
+	vector<pair<int,int> >::iterator it=upper_bound(at.begin(),at.end(),make_pair(d->id,vers[b].pos));
+	return it!=at.end()&&it->first==d->id;
+}
+
+/*
+	Class of a version
+*/
+int SSA::find(int v)
+{
+	while(vers[v].parent!=v){
+		vers[v].parent=vers[vers[v].parent].parent;
+		v=vers[v].parent;
+	}
+	return v;
+}
+
+/*
+	Versions of a class
+*/
+SSA::Class* SSA::getClass(int root)
+{
+	if(!members[root]){
+		members[root]=new Class;
+		members[root]->insert(make_pair(key(root),root));
+	}
+	return members[root];
+}
+
+/*
+	Closest version of c dominating v: the last one before v in preorder
+	or one of the versions dominating that one
+*/
+int SSA::ancestor(Class*c,int v)
+{
+	Class::iterator it=c->upper_bound(make_pair(key(v),INT_MAX));
+	if(it==c->begin())return -1;
+	int u=(--it)->second;
+	while(u>=0&&!dominates(u,v))u=vers[u].up;
+	return u;
+}
+
+/*
+	Join two classes unless a version of one interferes with a version of
+	the other. Each class is free of interference, so a version only has
+	to be checked against the closest versions of the other class above
+	and below it in the dominator tree: the smaller class is walked, and
+	below each of its versions the other class is visited one subtree at
+	a time.
+*/
+bool SSA::merge(int a,int b,bool check)
+{
+	Class*x=getClass(a);
+	Class*y=getClass(b);
+	if(x->size()<y->size()){
+		swap(a,b);
+		swap(x,y);
+	}
+	vector<pair<int,int> >links;//new closest dominating versions
+	for(Class::iterator i=y->begin();i!=y->end();++i){
+		int v=i->second;
+		int u=ancestor(x,v);
+		if(check&&u>=0&&liveAt(u,v))return false;
+		if(u>=0&&(vers[v].up<0||key(u)>key(vers[v].up)))links.push_back(make_pair(v,u));
+		Class::iterator j=x->lower_bound(make_pair(key(v),-1));
+		while(j!=x->end()&&j->first<end(v)){
+			int w=j->second;
+			if(w!=u){
+				if(check&&liveAt(v,w))return false;
+				links.push_back(make_pair(w,v));
+			}
+			j=x->lower_bound(make_pair(end(w),-1));//skip the versions below w
+		}
+	}
+	for(int i=0;i<links.size();i++)vers[links[i].first].up=links[i].second;
+	x->insert(y->begin(),y->end());
+	delete y;
+	members[b]=NULL;
+	vers[b].parent=a;
+	return true;
+}
+
+/*
+	Join the phi webs, then try the copies, innermost loops first
+*/
+void SSA::coalesce()
+{
+	members.assign(vers.size(),NULL);
+	for(int v=0;v<vers.size();v++){
+		vers[v].parent=v;
+		vers[v].up=-1;
+	}
+	vector<Block*>&order=dfg->getOrder();
+	for(int i=0;i<order.size();i++){
+		vector<Phi*>&bp=phis[order[i]->id];
+		for(int j=0;j<bp.size();j++){
+			for(int a=0;a<bp[j]->args.size();a++){
+				if(!bp[j]->args[a])continue;
+				int r=find(version(bp[j]->result));
+				int v=find(version(bp[j]->args[a]));
+				if(v!=r)merge(r,v,false);
+			}
+		}
+	}
+	vector<InterInst*>moves;
+	for(int i=0;i<order.size();i++){
+		Block*b=order[i];
+		for(int j=0;j<b->insts.size();j++){
+			InterInst*inst=b->insts[j];
+			if(inst->isLb()||inst->isDead||inst->getOp()!=OP_AS)continue;
+			int x=version(inst->getResult()),y=version(inst->getArg1());
+			if(x<0||y<0)continue;
+			Var*p=vars[vers[x].origin];
+			Var*q=vars[vers[y].origin];
+			if(p->getType()!=q->getType()||p->getPtr()!=q->getPtr())continue;//copies that convert
+			moves.push_back(inst);
+		}
+	}
+	stable_sort(moves.begin(),moves.end(),[](InterInst*p,InterInst*q){
+		return p->block->loopDepth>q->block->loopDepth;
+	});
+	for(int i=0;i<moves.size();i++){
+		int x=find(version(moves[i]->getResult()));
+		int y=find(version(moves[i]->getArg1()));
+		if(x==y||merge(x,y,true))coalesced++;
+	}
+	for(int v=0;v<members.size();v++)
+		delete members[v];
+}
+
+/*
+	Give every class one variable: the entry value of a variable when the
+	class holds one that is read, otherwise one of its versions as a new
+	temporary. Copies inside a class disappear.
+*/
+void SSA::rewrite()
+{
+	vector<int>pick(vers.size(),-1);//version naming each class
+	vector<bool>entry(vers.size(),false);//the pick is an entry value that is read
+	vector<bool>used(vers.size(),false);//class referenced by the code
+	for(int v=0;v<vers.size();v++){
+		Version&ver=vers[v];
+		if(!ver.block)continue;
+		int r=find(v);
+		if(ver.def||!ver.uses.empty())used[r]=true;
+		bool read=v<vars.size()&&(!ver.uses.empty()||!ver.phiUses.empty());
+		if(pick[r]<0||read&&!entry[r]){
+			pick[r]=v;
+			entry[r]=read;
+		}
+	}
+	vector<Var*>var(vers.size(),NULL);
+	vector<InterInst*>decs;
+	unordered_set<Var*>params(fun->getParaVar().begin(),fun->getParaVar().end());
+	for(int r=0;r<vers.size();r++){
+		if(!used[r])continue;
+		Var*rep=vers[pick[r]].var;
+		var[r]=rep;
+		classes++;
+		if(pick[r]>=vars.size()){
+			vers[pick[r]].owned=false;//the symbol table frees it
+			tab->AddTemp(rep);
+			decs.push_back(new InterInst(OP_DEC,rep));
+		}
+		else if(!params.count(rep))
+			decs.push_back(new InterInst(OP_DEC,rep));
+	}
+	vector<InterInst*>&code=fun->getCode();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb()||inst->isDead)continue;
+		Var*uses[2];
+		int n=inst->getUses(uses);
+		for(int u=0;u<n;u++){
+			int v=version(uses[u]);
+			if(v>=0)inst->replaceUse(uses[u],var[find(v)]);
+		}
+		int v=version(inst->getDef());
+		if(v>=0)inst->setResult(var[find(v)]);
+		if(inst->getOp()==OP_AS&&inst->getResult()==inst->getArg1())inst->isDead=true;
+	}
+	vector<InterInst*>out;
+	out.reserve(code.size()+decs.size());
+	out.push_back(code[0]);
+	out.insert(out.end(),decs.begin(),decs.end());
+	out.insert(out.end(),code.begin()+1,code.end());
+	code.swap(out);
+	fun->getInterCode().removeDead();
+}
+
+/*
+	Leave SSA form
+*/
+void SSA::destruct()
+{
+	if(!vars.empty()){
+		isolate();
+		collect();
+		computeLiveOut();
+		coalesce();
+		rewrite();
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: ssa %d variables, %d versions, %d phis, %d copies inserted, %d coalesced, %d variables after\n",
+			fun->getName().c_str(),(int)vars.size(),(int)vers.size(),phiCount,copies,coalesced,classes);
+}
+
+/*
+	Variable of a version, NULL if v is not in SSA form
+*/
+Var* SSA::getOrigin(Var*v)
+{
+	int i=version(v);
+	return i<0?NULL:vars[vers[i].origin];
+}
+
+/*
+	Defining instruction, NULL for phis and entry values
+*/
+InterInst* SSA::getDef(Var*v)
+{
+	int i=version(v);
+	return i<0?NULL:vers[i].def;
+}
+
+/*
+	Defining phi function, NULL otherwise
+*/
+Phi* SSA::getPhi(Var*v)
+{
+	int i=version(v);
+	return i<0?NULL:vers[i].phi;
+}
+
+/*
+	Instructions reading a version
+*/
+vector<InterInst*>& SSA::getUses(Var*v)
+{
+	static vector<InterInst*>none;
+	int i=version(v);
+	return i<0?none:vers[i].uses;
+}
+
+/*
+	Phi functions of a block
+*/
+vector<Phi*>& SSA::getPhis(Block*b)
+{
+	return phis[b->id];
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+#include <set>
+
+class Fun;
+class SymTab;
+class DFG;
+class Block;
+class InterInst;
+class Var;
+
+/*
+	Phi function at the head of a block
+*/
+struct Phi
+{
+	Var*var;//variable merged by the phi
+	Var*result;//version defined by the phi
+	vector<Var*>args;//version from each predecessor, NULL for unreachable ones
+};
+
+/*
+	Static single assignment form of the scalar locals, parameters and
+	temporaries whose address is never taken (Var::inMem clear).
+	build places phi functions on the iterated dominance frontiers of the
+	definitions of variables live across blocks and gives every definition
+	its own version while walking the dominator tree. Each version then has
+	one definition and a list of uses, the entry value of a variable is the
+	variable itself.
+	destruct isolates the phi operands with copies at the end of the
+	predecessors and at the head of the block, coalesces the versions of
+	copies whose live ranges do not interfere and gives every class one
+	variable. Classes without the entry value become temporaries, which the
+	frame layout packs by live range.
+*/
+class SSA
+{
+	//one version of a variable
+	struct Version
+	{
+		Var*var;//the version
+		int origin;//index of its variable
+		InterInst*def;//defining instruction, NULL for the entry value and phis
+		Phi*phi;//defining phi
+		Block*block;//block of the definition, NULL when it is not defined
+		int pos;//position in the block, -1 for phis, -2 for the entry value
+		vector<InterInst*>uses;//instructions reading it
+		vector<pair<int,int> >at;//block id and position of the uses, sorted
+		vector<Block*>phiUses;//predecessors along which a phi reads it
+		int parent;//coalescing class, union find
+		int up;//closest version of the class dominating it, -1 if none
+		bool owned;//freed with the pass unless it names a class
+	};
+
+	Fun*fun;
+	SymTab*tab;
+	DFG*dfg;
+	vector<Var*>vars;//variables in SSA form, their entry values are versions 0..n-1
+	vector<Version>vers;//all versions, Var::index locates a version
+	vector<vector<Phi*> >phis;//phi functions by block id
+	vector<vector<int> >liveOut;//versions live at the end of each block, sorted
+	typedef set<pair<long long,int> > Class;//versions ordered by the dominator tree preorder
+	vector<Class*>members;//versions of each class by its root, NULL for a single version
+	unordered_map<int,Var*>literals;//literal cache
+	int phiCount;//phi functions kept
+	int copies;//copies inserted to leave SSA
+	int coalesced;//copies removed by coalescing
+	int classes;//variables after coalescing
+
+	static bool candidate(Var*v);//scalar with no address taken
+	Var* literal(int val);//literal variable
+	int version(Var*v);//index of a version, -1 for other variables
+	int newVersion(int k);//new version of variable k
+	void findVars();//collect the variables to rename
+	void placePhis();//phi functions on iterated dominance frontiers
+	void rename();//one version per definition along the dominator tree
+	void prunePhis();//remove phi functions without uses
+	void collect();//definitions and uses of the versions
+	void isolate();//copies around the phi functions
+	void computeLiveOut();//block live out sets of the versions
+	long long key(int v);//place of the definition in dominator tree preorder
+	long long end(int v);//first key after the definitions dominated by v
+	bool dominates(int a,int b);//definition of a dominates that of b
+	bool liveAt(int a,int b);//a is live just after the definition of b
+	int find(int v);//class of a version
+	Class* getClass(int root);//versions of a class
+	int ancestor(Class*c,int v);//closest version of c dominating v, -1 if none
+	bool merge(int a,int b,bool check);//join two classes unless they interfere
+	void coalesce();//join the phi webs and the copies
+	void rewrite();//one variable per class
+public:
+	SSA(Fun*fun,SymTab*tab);
+	~SSA();
+
+	void build();//convert to SSA form
+	void destruct();//leave SSA form
+
+	Var* getOrigin(Var*v);//variable of a version, NULL if v is not in SSA form
+	InterInst* getDef(Var*v);//defining instruction, NULL for phis and entry values
+	Phi* getPhi(Var*v);//defining phi function, NULL otherwise
+	vector<InterInst*>& getUses(Var*v);//instructions reading a version
+	vector<Phi*>& getPhis(Block*b);//phi functions of a block
+};
@@ -3,6 +3,8 @@
 #include "interCode.h"
 #include "genIr.h"
 #include "symbolTable.h"
+#include "passManager.h"
+#include "args.h"
 #include <sstream>
 
 //打印语义错误
@@ -42,6 +44,14 @@ Var* Var::getTrue()
 	return SymTab::one;
 }
 
+/*
+	获取false变量
+*/
+Var* Var::getFalse()
+{
+	return SymTab::zero;
+}
+
 /*
 	获取步长变量
 */
@@ -525,6 +535,7 @@ string Var::valueStr()
 	}
 	else
         return name;
+	return name;
 }
 
 /*
@@ -585,8 +596,16 @@ Fun::Fun(bool ext,Tag t,string n,vector<Var*>&paraList)
 	for(int i=0,argOff=4;i<paraVar.size();i++,argOff+=4){//初始化参数变量地址从左到右，参数进栈从右到左
 		paraVar[i]->setOffset(argOff);
 	}
+	curEsp=0;//frame starts at ebp
+	maxDepth=0;
+	returnPoint=NULL;
 	//dfg=NULL;
 	relocated=false;
+	summarized=false;
+	stores=true;
+	halts=false;
+	constRet=false;
+	retVal=0;
 }
 
 Fun::~Fun()
@@ -667,6 +686,22 @@ void Fun::addInst(InterInst*inst)
 	interCode.addInst(inst);
 }
 
+/*
+	Get the code sequence
+*/
+vector<InterInst*>& Fun::getCode()
+{
+	return interCode.getCode();
+}
+
+/*
+	Get the intermediate code
+*/
+InterCode& Fun::getInterCode()
+{
+	return interCode;
+}
+
 /*
 	设置函数返回点
 */
@@ -709,6 +744,80 @@ void Fun::setExtern(bool ext)
 	externed=ext;
 }
 
+/*
+	Record the side effects of the finished function
+*/
+void Fun::summarize(bool st,bool ht,vector<Var*>&rd,vector<Var*>&wr,bool cr,int rv)
+{
+	summarized=true;
+	stores=st;
+	halts=ht;
+	reads=rd;
+	writes=wr;
+	constRet=cr;
+	retVal=rv;
+}
+
+/*
+	The summary is known
+*/
+bool Fun::isSummarized()
+{
+	return summarized;
+}
+
+/*
+	Writes memory only through the globals of getWrites: no store through
+	a pointer nor a call to an unknown function
+*/
+bool Fun::knownEffects()
+{
+	return summarized&&!stores;
+}
+
+/*
+	Writes no memory at all, a call whose result is unused can go
+*/
+bool Fun::isPure()
+{
+	return knownEffects()&&writes.empty();
+}
+
+/*
+	Returns from every call: it has no loop and calls only functions that
+	terminate, so a recursive call never does
+*/
+bool Fun::terminates()
+{
+	return summarized&&halts;
+}
+
+/*
+	Globals read, callees included
+*/
+vector<Var*>& Fun::getReads()
+{
+	return reads;
+}
+
+/*
+	Globals written, callees included
+*/
+vector<Var*>& Fun::getWrites()
+{
+	return writes;
+}
+
+/*
+	Every return gives the same literal, val gets it
+*/
+bool Fun::constReturn(int&val)
+{
+	if(!summarized||!constRet)return false;
+	val=retVal;
+	return true;
+}
+
 /*
 	获取extern
 */
@@ -762,54 +871,16 @@ void Fun::toString()
 	}
 }
 
-#if 0
 /*
-	执行优化操作
+	执行优化操作, the pass pipeline rewrites the code in place
 */
 void Fun::optimize(SymTab*tab)
 {
 	if(externed)return;//函数声明不处理
-	//数据流图
-	dfg=new DFG(interCode);//创建数据流图
-	if(Args::showBlock)dfg->toString();//输出基本块和流图关系
 	if(!Args::opt)return;//不执行优化
-
-	//常量传播：代数化简，条件跳转优化，不可达代码消除
-	ConstPropagation conPro(dfg,tab,paraVar);//常量传播
-#ifdef CONST
-	conPro.propagate();//常量传播
-#endif
-
-	//冗余消除
-	RedundElim re(dfg,tab);	
-#ifdef RED
-	re.elimate();
-#endif
-
-	//复写传播
-	CopyPropagation cp(dfg);
-#ifdef DEAD
-	cp.propagate();
-#endif
-	
-	//活跃变量
-	LiveVar lv(dfg,tab,paraVar);
-#ifdef DEAD
-	lv.elimateDeadCode();
-#else
-	#ifdef REG
-		lv.analyse();
-	#endif
-#endif
-
-	//优化结果存储在optCode
-	dfg->toCode(optCode);//导出数据流图为中间代码
-
-	//寄存器分配和局部变量栈地址重新计算
-	CoGraph cg(optCode,paraVar,&lv,this);//初始化冲突图
-	cg.alloc();//重新分配变量的寄存器和栈帧地址
+	PassManager::run(this,tab);
 }
-#endif
+
 /*
 	输出中间代码
 */
@@ -836,91 +907,36 @@ void Fun::printOptCode()
 }
 #endif
 
-void Fun::genIr(FILE*file)
+/*
+	Output the function's intermediate code and/or assembly in a single
+	traversal of its code, a NULL file skips that output
+*/
+void Fun::genCode(FILE*irFile,FILE*asmFile)
 {
 	if(externed)return;
-	//导出最终的代码,如果优化则是优化后的中间代码，否则就是普通的中间代码
-	vector<InterInst*> code;
-#if 0
-	if(Args::opt){//经过优化
-		for(list<InterInst*>::iterator it=optCode.begin();it!=optCode.end();++it){
-			code.push_back(*it);
-		}
-	}
-	else
-#endif
-    {//未优化，将中间代码导出
-		code=interCode.getCode();
-	}
+	vector<InterInst*>& code=interCode.getCode();
 	const char* pname=name.c_str();
-	fprintf(file,"#函数%s代码\n",pname);
-	fprintf(file,"\t.global %s\n",pname);//.global fun\n
-	fprintf(file,"%s:\n",pname);//fun:\n
-	
-    for(int i=0;i<code.size();i++)
+	FILE* files[2]={irFile,asmFile};
+	for(int i=0;i<2;i++){
+		if(!files[i])continue;
+		fprintf(files[i],"#函数%s代码\n",pname);
+		fprintf(files[i],"\t.global %s\n",pname);//.global fun\n
+		fprintf(files[i],"%s:\n",pname);//fun:\n
+	}
+	for(int i=0;i<code.size();i++)
 	{
-		fprintf(file, "%s", code[i]->InstToStr().c_str());
+		if(irFile)fputs(code[i]->InstToStr().c_str(),irFile);
+		if(asmFile)code[i]->ToX86(asmFile,this);
 	}
-
-#if 0
-	ILoc il;//ILOC代码
-	//将最终的中间代码转化为ILOC代码
-	Selector sl(code,il);//指令选择器
-	sl.select();
-	//对ILOC代码进行窥孔优化
-	PeepHole ph(il);//窥孔优化器
-#ifdef PEEP
-	if(Args::opt)ph.filter();//优化过滤代码
-#endif
-
-	//将优化后的ILOC代码输出为汇编代码
-	il.outPut(file);
-#endif
 }
+
 /*
-	输出汇编代码
+	Free the code once it has been emitted
 */
-void Fun::genAsm(FILE*file)
+void Fun::releaseCode()
 {
-	if(externed)return;
-	//导出最终的代码,如果优化则是优化后的中间代码，否则就是普通的中间代码
-	vector<InterInst*> code;
-#if 0
-	if(Args::opt){//经过优化
-		for(list<InterInst*>::iterator it=optCode.begin();it!=optCode.end();++it){
-			code.push_back(*it);
-		}
-	}
-	else
-#endif
-    {//未优化，将中间代码导出
-		code=interCode.getCode();
-//		interCode.toString();
-	}
-	const char* pname=name.c_str();
-	fprintf(file,"#函数%s代码\n",pname);
-	fprintf(file,"\t.global %s\n",pname);//.global fun\n
-	fprintf(file,"%s:\n",pname);//fun:\n
-
-    for(int i=0;i<code.size();i++)
-	{
-		code[i]->ToX86(file);
-	}
-
-#if 0
-	ILoc il;//ILOC代码
-	//将最终的中间代码转化为ILOC代码
-	Selector sl(code,il);//指令选择器
-	sl.select();
-	//对ILOC代码进行窥孔优化
-	PeepHole ph(il);//窥孔优化器
-#ifdef PEEP
-	if(Args::opt)ph.filter();//优化过滤代码
-#endif
-
-	//将优化后的ILOC代码输出为汇编代码
-	il.outPut(file);
-#endif
+	interCode.clear();
+	returnPoint=NULL;//owned by the code
 }
 
 /*
@@ -941,6 +957,22 @@ void Fun::setMaxDep(int dep)
 	relocated=true;
 }
 
+/*
+	Callee saved registers the allocator handed out
+*/
+void Fun::setSaved(vector<int>&regs)
+{
+	saved=regs;
+}
+
+/*
+	Saved registers, slot i at [ebp-maxDepth+4*i]
+*/
+vector<int>& Fun::getSaved()
+{
+	return saved;
+}
+
 /*
 	函数栈帧被重新定位了？
 */
@@ -6,6 +6,8 @@
 #include "interCode.h"
 //#include "set.h"
 
+class SymTab;
+
 class Var
 {
 	//特殊标记
@@ -48,6 +50,7 @@ public:
 	static Var*getStep(Var* v);//获取步长变量
 	static Var* GetVoid();//获取void特殊变量
 	static Var*getTrue();//获取true变量
+	static Var*getFalse();//获取false变量
 	
 	//构造函数
 	Var(vector<int>&sp,bool ext,Tag t,bool ptr,string name,Var*init=NULL);//变量
@@ -111,11 +114,21 @@ class Fun
 	int maxDepth;//栈的最大深度，初始0,标识函数栈分配的最大空间
 	int curEsp;//当前栈指针位置，初始化为0，即ebp存储点
 	bool relocated;//栈帧重定位标记
+	vector<int>saved;//callee saved registers in use, kept at the bottom of the frame
 	
 	//作用域管理
 	vector<int>scopeEsp;//当前作用域初始esp，动态控制作用域的分配和释放
 	InterCode interCode;//中间代码
 	InterInst* returnPoint;//返回点
+
+	//副作用摘要，函数定义结束后由调用图给出
+	bool summarized;//the summary is known
+	bool stores;//may write memory through a pointer, itself or in a callee
+	bool halts;//returns from every call: no loop and only callees that halt
+	vector<Var*>reads;//globals read, callees included
+	vector<Var*>writes;//globals written, callees included
+	bool constRet;//every return gives retVal
+	int retVal;//constant return value
 	//DFG* dfg;//数据流图指针
 	//list<InterInst*> optCode;//优化后的中间代码
 public:
@@ -136,11 +149,25 @@ public:
 	
 	//中间代码
 	void addInst(InterInst*inst);//添加一条中间代码
+	vector<InterInst*>& getCode();//get the code sequence
+	InterCode& getInterCode();//get the intermediate code
 	void setReturnPoint(InterInst*inst);//设置函数返回点
 	InterInst* getReturnPoint();//获取函数返回点
 	int getMaxDep();//获取最大栈帧深度
 	void setMaxDep(int dep);//设置最大栈帧深度
-	//void optimize(SymTab*tab);//执行优化操作
+	void setSaved(vector<int>&regs);//callee saved registers the allocator handed out
+	vector<int>& getSaved();//saved registers, slot i at [ebp-maxDepth+4*i]
+	void optimize(SymTab*tab);//执行优化操作
+
+	//副作用摘要
+	void summarize(bool st,bool ht,vector<Var*>&rd,vector<Var*>&wr,bool cr,int rv);//set by the call graph
+	bool isSummarized();//the summary is known
+	bool knownEffects();//writes memory only through the globals of getWrites
+	bool isPure();//writes no memory at all
+	bool terminates();//returns from every call
+	vector<Var*>& getReads();//globals read
+	vector<Var*>& getWrites();//globals written
+	bool constReturn(int&val);//every return gives the same literal
 	
 	//外部调用掉口
 	bool getExtern();//获取extern
@@ -152,6 +179,6 @@ public:
 	void toString();//输出信息
 	void printInterCode();//输出中间代码
 	void printOptCode();//输出优化后的中间代码
-	void genIr(FILE*file); // Output IR
-	void genAsm(FILE*file);//输出汇编代码
+	void genCode(FILE*irFile,FILE*asmFile);//Output IR and asm in one pass, NULL skips an output
+	void releaseCode();//free the code once it has been emitted
 };
@@ -1,6 +1,17 @@
 #include "symbolTable.h"
 #include "symbol.h"
 #include "genIr.h"
+#include "frameLayout.h"
+#include "regAlloc.h"
+#include "dfg.h"
+#include "liveVar.h"
+#include "reachDef.h"
+#include "availExpr.h"
+#include "inliner.h"
+#include "args.h"
+#include <stdarg.h>
+#include <unordered_set>
+#include <time.h>
 
 //打印语义错误
 #define SEMERROR(code,name) printf("%s %d, error\n", __func__, __LINE__)
@@ -24,7 +35,7 @@ SymTab::SymTab()
 		此处产生特殊的常量void，1,4
 	*/
 	voidVar=new Var();//void变量
-	zero=new Var(1);//常量0
+	zero=new Var(0);//常量0
 	one=new Var(1);//常量1
 	four=new Var(4);//常量4
 	AddVar(voidVar);//让符号表管理这些特殊变量
@@ -34,6 +45,11 @@ SymTab::SymTab()
 
 	scopeId=0;
 	curFun=NULL;
+	streamIr=NULL;
+	streamAsm=NULL;
+	streaming=false;
+	textStarted=false;
+	callGraph=new CallGraph();
 	//ir=NULL;
 	scopePath.push_back(0);//全局作用域	
 }
@@ -57,6 +73,7 @@ SymTab::~SymTab()
 	//清除串
 	for(auto strIt=strTab.begin();strIt!=strTab.end();++strIt)
 		delete strIt->second;	
+	delete callGraph;
 }
 
 /*
@@ -101,11 +118,27 @@ void SymTab::AddVar(Var* var)
 			return;//无效变量，删除，不定位
 		}
 	}
+	if(streaming&&curFun)funVars.push_back(var);//freed with the function
 	if(ir){
 		int flag=ir->GenVarInit(var);//产生变量初始化语句,常量返回0
 		if(curFun&&flag)curFun->locate(var);//计算局部变量的栈帧偏移
 	}
 }
+
+/*
+	Register a temporary created by the optimizer. No code is generated,
+	the caller places its declaration and the frame layout gives it a slot.
+*/
+void SymTab::AddTemp(Var* var)
+{
+	vector<Var*>*&list=varTab[var->getName()];
+	if(!list){
+		list=new vector<Var*>;
+		varList.push_back(var->getName());
+	}
+	list->push_back(var);
+	if(streaming&&curFun)funVars.push_back(var);//freed with the function
+}
 /*
 	添加一个字符串常量
 */
@@ -185,6 +218,14 @@ Fun* SymTab::GetCurFun()
 	return curFun;
 }
 
+/*
+	Call graph of the finished functions
+*/
+CallGraph* SymTab::GetCallGraph()
+{
+	return callGraph;
+}
+
 /*
 	声明一个函数
 */
@@ -237,15 +278,116 @@ void SymTab::DefFun(Fun* fun)
 	ir->GenFunHead(curFun);//产生函数入口
 }
 
+/*
+	Solve the dataflow analyses of a function, print them for --show-dataflow
+	and report the size and cost of every solve for --time-dataflow
+*/
+static void showDataFlow(Fun*fun,DFG*dfg)
+{
+	vector<InterInst*>&code=fun->getCode();
+	const char*name=fun->getName().c_str();
+	clock_t t0=clock();
+	LiveVar live(dfg,code);
+	clock_t t1=clock();
+	ReachDef reach(dfg,code);
+	clock_t t2=clock();
+	AvailExpr avail(dfg,code);
+	clock_t t3=clock();
+	if(Args::showFlow){
+		printf("-------------<%s>DataFlow--------------\n",name);
+		live.toString();
+		reach.toString();
+		avail.toString();
+	}
+	if(Args::timeFlow){
+		int blocks=dfg->getOrder().size();
+		DataFlow*flows[3]={&live,&reach,&avail};
+		const char*kinds[3]={"live","reach","avail"};
+		const char*units[3]={"vars","defs","exprs"};
+		clock_t times[4]={t0,t1,t2,t3};
+		for(int i=0;i<3;i++)
+			fprintf(stderr,"%s: %d blocks, %s %d %s %d sweeps %d visits %.2f ms%s\n",
+				name,blocks,kinds[i],flows[i]->getWidth(),units[i],flows[i]->getSweeps(),
+				flows[i]->getVisits(),(times[i+1]-times[i])*1000.0/CLOCKS_PER_SEC,
+				flows[i]->isLocal()?" (over budget, block local)":"");
+	}
+}
+
 /*
 	结束定义一个函数
 */
 void SymTab::EndDefFun()
 {
 	ir->GenFunTail(curFun);//产生函数出口
+	curFun->optimize(this);//优化
+	callGraph->add(curFun);//calls of the optimized code
+	if(Args::showBlock||Args::showFlow||Args::timeFlow){
+		DFG dfg(curFun->getInterCode());
+		if(Args::showBlock){
+			printf("-------------<%s>CFG--------------\n",curFun->getName().c_str());
+			dfg.toString();
+		}
+		if(Args::showFlow||Args::timeFlow)showDataFlow(curFun,&dfg);
+	}
+#ifdef REG
+	RegAllocator regs(curFun);//scalars to registers before the frame is laid out
+	regs.allocate();
+#endif
+	FrameLayout layout(curFun);//temporaries share stack slots by live range
+	layout.relocate();
+	if(Args::stats)
+		fprintf(stderr,"%s: frame %d -> %d bytes\n",curFun->getName().c_str(),
+			layout.getBefore(),layout.getAfter());
+	if(streaming){
+		//emit right away and free the code and temporaries, so peak memory
+		//follows the largest function instead of the whole program
+		genTextHead(streamIr,streamAsm);
+		curFun->genCode(streamIr,streamAsm);
+		if(Args::opt&&callGraph->keep(curFun))
+			vector<Var*>().swap(funVars);//small enough to be inlined later, keep it
+		else{
+			curFun->releaseCode();
+			releaseFunVars();
+		}
+	}
 	curFun=NULL;//当前分析的函数置空
 }
 
+/*
+	Drop the current function's variables from the tables and free them,
+	nothing outside the function's code can refer to them any more
+*/
+void SymTab::releaseFunVars()
+{
+	if(funVars.empty())return;
+	unordered_set<Var*> dead(funVars.begin(),funVars.end());
+	unordered_set<string> emptied;
+	for(int i=0;i<funVars.size();i++){
+		string name=funVars[i]->getName();
+		auto it=varTab.find(name);
+		if(it==varTab.end())continue;//list already handled
+		vector<Var*>&list=*it->second;
+		int keep=0;
+		for(int j=0;j<list.size();j++)
+			if(!dead.count(list[j]))list[keep++]=list[j];
+		list.resize(keep);
+		if(!keep){
+			delete &list;
+			varTab.erase(it);
+			emptied.insert(name);
+		}
+	}
+	if(!emptied.empty()){
+		int keep=0;
+		for(int i=0;i<varList.size();i++)
+			if(!emptied.count(varList[i]))varList[keep++]=varList[i];
+		varList.resize(keep);
+	}
+	for(int i=0;i<funVars.size();i++)
+		delete funVars[i];
+	vector<Var*>().swap(funVars);
+}
+
 /*
 	添加一条中间代码
 */
@@ -274,18 +416,6 @@ void SymTab::Leave()
 	if(curFun)curFun->leaveScope();
 }
 
-#if 0
-/*
-	执行优化操作
-*/
-void SymTab::optimize()
-{
-	for(int i=0;i<funList.size();i++){
-		funTab[funList[i]]->optimize(this);
-	}
-}
-#endif
-
 /*
 	输出符号表信息
 */
@@ -333,85 +463,103 @@ void SymTab::printOptCode()
 }
 
 #endif
-void SymTab::genData(FILE*file)
+/*
+	Format once and write to every requested output
+*/
+static void emitAll(FILE*irFile,FILE*asmFile,const char*fmt,...)
+{
+	char buf[256];
+	va_list args;
+	va_start(args,fmt);
+	int len=vsnprintf(buf,sizeof(buf),fmt,args);
+	va_end(args);
+	string big;
+	const char*text=buf;
+	if(len>=(int)sizeof(buf)){//long string constants
+		big.resize(len+1);
+		va_start(args,fmt);
+		vsnprintf(&big[0],len+1,fmt,args);
+		va_end(args);
+		text=big.c_str();
+	}
+	if(irFile)fputs(text,irFile);
+	if(asmFile)fputs(text,asmFile);
+}
+
+/*
+	Output data sections to both outputs
+*/
+void SymTab::genData(FILE*irFile,FILE*asmFile)
 {
 	//生成常量字符串,.rodata段
-	fprintf(file, ".section .rodata\n");
+	emitAll(irFile,asmFile,".section .rodata\n");
 	for(auto strIt=strTab.begin();strIt!=strTab.end();++strIt){
 		Var*str=strIt->second;//常量字符串变量
-		fprintf(file, "%s:\n", str->getName().c_str());//var:
-		fprintf(file, "\t.ascii \"%s\"\n", str->getRawStr().c_str());//.ascii "abc\000"
+		emitAll(irFile,asmFile,"%s:\n",str->getName().c_str());//var:
+		emitAll(irFile,asmFile,"\t.ascii \"%s\"\n",str->getRawStr().c_str());//.ascii "abc\000"
 	}
 	//生成数据段和bss段
-	fprintf(file, ".data\n");
+	emitAll(irFile,asmFile,".data\n");
 	vector<Var*> glbVars=GetGlbVars();//获取所有全局变量
 	for(unsigned int i=0;i<glbVars.size();i++)
 	{
 		Var*var=glbVars[i];
-		fprintf(file, "\t.global %s\n",var->getName().c_str());//.global var
+		emitAll(irFile,asmFile,"\t.global %s\n",var->getName().c_str());//.global var
 		if(!var->unInit()){//变量初始化了,放在数据段
-			fprintf(file, "%s:\n", var->getName().c_str());//var:
+			emitAll(irFile,asmFile,"%s:\n",var->getName().c_str());//var:
 			if(var->isBase()){//基本类型初始化 100 'a'
 				const char* t=var->isChar()?".byte":".word";
-				fprintf(file, "\t%s %d\n", t, var->getVal());//.byte 65  .word 100
+				emitAll(irFile,asmFile,"\t%s %d\n",t,var->getVal());//.byte 65  .word 100
 			}
 			else{//字符指针初始化
-				fprintf(file, "\t.word %s\n",var->getPtrVal().c_str());//.word .L0
+				emitAll(irFile,asmFile,"\t.word %s\n",var->getPtrVal().c_str());//.word .L0
 			}
 		}
 		else{//放在bss段
-			fprintf(file, "\t.comm %s,%d\n", var->getName().c_str(), var->getSize());//.comm var,4
+			emitAll(irFile,asmFile,"\t.comm %s,%d\n",var->getName().c_str(),var->getSize());//.comm var,4
 		}
 	}
 }
 
 /*
-	输出汇编文件
+	Output text section header once
 */
-//void SymTab::genAsm(char*fileName)
-void SymTab::genAsm(FILE* file)
+void SymTab::genTextHead(FILE*irFile,FILE*asmFile)
 {
-#if 0
-	//将.c替换为.o，或者直接追加.o
-	string newName=fileName;
-	int pos=newName.rfind(".c");
-	if(pos>0&&pos==newName.length()-2){
-		newName.replace(pos,2,".s");
-	}
-	else newName=newName+".s";
-	FILE* file=fopen(newName.c_str(),"w");//创建输出文件
-#endif
-	//生成数据段
-	genData(file);
-	//生成代码段
-	//if(Args::opt)fprintf(file,"#优化代码\n");
-	if(false)fprintf(file,"#优化代码\n");
-	else fprintf(file,"#未优化代码\n");
-	fprintf(file,".text\n");
-	for(int i=0;i<funList.size();i++){
-		//printf("-------------生成函数<%s>--------------\n",funTab[funList[i]]->getName().c_str());
-		funTab[funList[i]]->genAsm(file);
-	}
-	//fclose(file);
+	if(textStarted)return;
+	textStarted=true;
+	if(Args::opt)emitAll(irFile,asmFile,"#优化代码 -O%d\n",Args::opt);
+	else emitAll(irFile,asmFile,"#未优化代码\n");
+	emitAll(irFile,asmFile,".text\n");
 }
 
-void SymTab::genIr(FILE* file)
+/*
+	Emit and free each function when its definition ends,
+	genCode then only writes the global data
+*/
+void SymTab::SetStream(FILE*irFile,FILE*asmFile)
 {
+	streamIr=irFile;
+	streamAsm=asmFile;
+	streaming=true;
+}
+
+/*
+	Output intermediate code and/or assembly in a single traversal,
+	a NULL file skips that output
+*/
+void SymTab::genCode(FILE*irFile,FILE*asmFile)
+{
+	if(!irFile&&!asmFile)return;
+	if(streaming){//functions were written as they ended, data goes last
+		genData(irFile,asmFile);
+		return;
+	}
 	//生成数据段
-	genData(file);
+	genData(irFile,asmFile);
 	//生成代码段
-	//if(Args::opt)fprintf(file,"#优化代码\n");
-	if(false)fprintf(file,"#优化代码\n");
-	else fprintf(file,"#未优化代码\n");
-	fprintf(file,".text\n");
+	genTextHead(irFile,asmFile);
 	for(int i=0;i<funList.size();i++){
-		//printf("-------------生成函数<%s>--------------\n",funTab[funList[i]]->getName().c_str());
-		funTab[funList[i]]->genIr(file);
+		funTab[funList[i]]->genCode(irFile,asmFile);
 	}
 }
-
-
-
-
-
-
@@ -8,6 +8,7 @@
 #include "interCode.h"
 
 class GenIR;
+class CallGraph;
 /*
 	符号表
 */
@@ -29,6 +30,18 @@ class SymTab
 
 	//中间代码生成器
 	GenIR* ir;
+
+	//调用图，内联使用
+	CallGraph* callGraph;
+
+	//streaming output
+	FILE* streamIr;//IR output when streaming, else NULL
+	FILE* streamAsm;//asm output when streaming, else NULL
+	bool streaming;//functions are emitted by EndDefFun
+	bool textStarted;//text section header written
+	vector<Var*> funVars;//variables created inside the current function
+	void genTextHead(FILE*irFile,FILE*asmFile);//output text section header
+	void releaseFunVars();//drop the current function's variables from the tables
 public:
 
 	static Var* voidVar;//特殊变量
@@ -45,6 +58,7 @@ public:
 	
 	//变量管理
 	void AddVar(Var* v);//添加一个变量
+	void AddTemp(Var* v);//register an optimizer temporary, its declaration is placed by the caller
 	void AddStr(Var* v);//添加一个字符串常量
 	Var* GetVar(string name);//获取一个变量
 	vector<Var*> GetGlbVars();//获取所有全局变量
@@ -60,14 +74,13 @@ public:
 	void SetIr(GenIR*ir);//设置中间代码生成器
 	vector<int>& GetScopePath();//获取scopePath
 	Fun*GetCurFun();//获取当前分析的函数
+	CallGraph*GetCallGraph();//call graph of the finished functions
 	void toString();//输出信息
 //	void printInterCode();//输出中间指令
-	void optimize();//执行优化操作
 //	void printOptCode();//输出中间指令
-	void genData(FILE*file);//输出数据
-//	void genAsm(char*fileName);//输出汇编文件
-	void genAsm(FILE* file);//输出汇编文件
-	void genIr(FILE* file); //Output IR
+	void genData(FILE*irFile,FILE*asmFile);//输出数据
+	void genCode(FILE*irFile,FILE*asmFile);//Output IR and asm in one pass, NULL skips an output
+	void SetStream(FILE*irFile,FILE*asmFile);//emit and free each function when its definition ends
 };
 
 
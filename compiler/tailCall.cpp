@@ -0,0 +1,173 @@
+#include "tailCall.h"
+#include "symbol.h"
+#include "symbolTable.h"
+#include "interCode.h"
+#include "args.h"
+#include <unordered_set>
+
+TailCall::TailCall(Fun*fun,SymTab*tab):fun(fun),tab(tab),loops(0),jumps(0)
+{
+}
+
+/*
+	The address of a local is taken, or a local array exists: a pointer
+	into the frame may reach the callee
+*/
+bool TailCall::escapes()
+{
+	vector<InterInst*>&code=fun->getCode();
+	for(int i=0;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isLb())continue;
+		Var*vars[3]={inst->getResult(),inst->getArg1(),inst->getArg2()};
+		if(inst->getOp()==OP_CALL||inst->getOp()==OP_PROC)vars[1]=NULL;//fun shares arg1
+		for(int j=0;j<3;j++){
+			Var*v=vars[j];
+			if(v&&v->notConst()&&v->getPath().size()>1&&(v->inMem||v->getArray()))return true;
+		}
+	}
+	return false;
+}
+
+/*
+	Follow the code after the call at i: labels and declarations are
+	passed, jumps followed and copies of the value to frame variables allowed, until the value is
+	returned, or the function returns without one
+*/
+bool TailCall::inTail(vector<InterInst*>&code,int i)
+{
+	InterInst*call=code[i];
+	bool hasVal=call->getOp()==OP_CALL;
+	if(hasVal&&fun->getType()!=KW_VOID&&call->getFun()->getType()!=fun->getType())
+		return false;//the value would be converted
+	unordered_set<Var*>vals;//variables holding the value
+	if(hasVal)vals.insert(call->getResult());
+	for(int j=i+1,steps=0;j<code.size()&&steps<code.size();steps++){
+		InterInst*inst=code[j];
+		Operator op=inst->getOp();
+		if(inst->isLb()||op==OP_DEC){//a declaration only sets a frame variable
+			j++;
+			continue;
+		}
+		if(op==OP_JMP){
+			j=pos[inst->getTarget()];
+			continue;
+		}
+		if(op==OP_AS&&vals.count(inst->getArg1())){
+			Var*v=inst->getResult();
+			if(v->getPath().size()==1||v->inMem||v->getArray())return false;//visible after the return
+			vals.insert(v);
+			j++;
+			continue;
+		}
+		if(op==OP_RETV)return hasVal&&vals.count(inst->getArg1());
+		if(op==OP_RET||op==OP_EXIT)return fun->getType()==KW_VOID;
+		return false;
+	}
+	return false;
+}
+
+/*
+	The pushes of a self tail call become copies to new temporaries, the
+	call becomes copies of those to the parameters and a jump to a label
+	after the entry. The code after the jump is left to unreachable code
+	elimination.
+*/
+void TailCall::loop()
+{
+	vector<InterInst*>&code=fun->getCode();
+	vector<Var*>&paras=fun->getParaVar();
+	pos.clear();
+	for(int i=0;i<code.size();i++)
+		if(code[i]->isLb())pos[code[i]]=i;
+	InterInst*start=NULL;//start of the body
+	vector<Var*>temps;//argument k of every site
+	unordered_map<InterInst*,vector<int> >sites;//call -> parameters changed
+	for(int i=0;i<code.size();i++){
+		InterInst*call=code[i];
+		if(call->isLb()||call->getOp()!=OP_CALL&&call->getOp()!=OP_PROC)continue;
+		if(call->getFun()!=fun)continue;
+		//the pushes of a call are the last ones before it
+		vector<InterInst*>args;
+		for(int j=i-1;j>0&&code[j]->getOp()==OP_ARG&&!code[j]->isLb()&&args.size()<paras.size();j--)
+			args.push_back(code[j]);
+		if(args.size()!=paras.size()||!inTail(code,i))continue;
+		if(!start){
+			start=new InterInst();
+			for(int k=0;k<paras.size();k++){
+				Var*t=new Var(paras[k]->getPath(),paras[k]);
+				tab->AddTemp(t);
+				temps.push_back(t);
+			}
+		}
+		vector<int>&changed=sites[call];
+		for(int k=0;k<args.size();k++){//the last push is the first parameter
+			if(args[k]->getArg1()==paras[k])args[k]->isDead=true;//unchanged
+			else{
+				args[k]->replace(OP_AS,temps[k],args[k]->getArg1());
+				changed.push_back(k);
+			}
+		}
+		loops++;
+	}
+	if(!start)return;
+	vector<InterInst*>out;
+	out.reserve(code.size()+temps.size()+1+sites.size()*(paras.size()+1));
+	out.push_back(code[0]);
+	for(int k=0;k<temps.size();k++)
+		out.push_back(new InterInst(OP_DEC,temps[k]));
+	out.push_back(start);
+	for(int i=1;i<code.size();i++){
+		InterInst*inst=code[i];
+		if(inst->isDead&&inst->getOp()==OP_ARG){
+			delete inst;
+			continue;
+		}
+		unordered_map<InterInst*,vector<int> >::iterator s=sites.find(inst);
+		if(s==sites.end()){
+			out.push_back(inst);
+			continue;
+		}
+		for(int n=0;n<s->second.size();n++){
+			int k=s->second[n];
+			out.push_back(new InterInst(OP_AS,paras[k],temps[k]));
+		}
+		out.push_back(new InterInst(OP_JMP,start));
+		delete inst;
+	}
+	code.swap(out);
+}
+
+/*
+	执行尾递归消除
+*/
+void TailCall::recursion()
+{
+	if(!escapes())loop();
+	if(Args::stats)
+		fprintf(stderr,"%s: %d tail recursions\n",fun->getName().c_str(),loops);
+}
+
+/*
+	Mark the tail calls left as jumps reusing the frame, the code generator
+	copies the pushed arguments to the slots of our parameters
+*/
+void TailCall::mark()
+{
+	vector<InterInst*>&code=fun->getCode();
+	if(!escapes()){
+		pos.clear();
+		for(int i=0;i<code.size();i++)
+			if(code[i]->isLb())pos[code[i]]=i;
+		for(int i=0;i<code.size();i++){
+			InterInst*call=code[i];
+			if(call->isLb()||call->getOp()!=OP_CALL&&call->getOp()!=OP_PROC)continue;
+			if(call->getFun()->getParaVar().size()>fun->getParaVar().size())continue;//no slots
+			if(!inTail(code,i))continue;
+			call->setTail();
+			jumps++;
+		}
+	}
+	if(Args::stats)
+		fprintf(stderr,"%s: %d tail jumps\n",fun->getName().c_str(),jumps);
+}
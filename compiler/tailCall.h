@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common.h"
+#include <unordered_map>
+
+class Fun;
+class SymTab;
+class InterInst;
+class Var;
+
+/*
+	Tail call elimination.
+	A call is in tail position when nothing but labels, jumps and copies of
+	its value to frame variables lie between it and the return of that
+	value, or the exit for a procedure.
+	A self tail call becomes copies of the arguments to the parameters and
+	a jump to the start of the body, so tail recursion runs as a loop which
+	the later passes optimize like any other.
+	Other tail calls are marked once the code is final: they store the
+	pushed arguments over the caller's own, leave the frame and jump to the
+	callee, which returns straight to our caller. This needs the callee to
+	take no more parameters than the caller has slots for.
+	Nothing is done when the address of a local may be held by the callee.
+*/
+class TailCall
+{
+	Fun*fun;
+	SymTab*tab;
+	int loops;//self tail calls turned into jumps
+	int jumps;//tail calls reusing the frame
+	unordered_map<InterInst*,int>pos;//label -> index
+
+	bool escapes();//the address of a local is taken
+	bool inTail(vector<InterInst*>&code,int i);//the call at i is in tail position
+	void loop();//turn the self tail calls into jumps
+public:
+	TailCall(Fun*fun,SymTab*tab);
+
+	void recursion();//执行尾递归消除
+	void mark();//mark the remaining tail calls as jumps
+};
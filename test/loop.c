@@ -0,0 +1,30 @@
+int limit = 5, count = 0;
+
+// Loops left only by a return or a break, main returns 55. The calls must
+// stay although spin writes no memory: with limit = 0 neither would ever return
+int spin()
+{
+	int n = 0;
+	while(1){
+		n = n + 1;
+		if(n == limit)return n;
+	}
+	return 0;
+}
+
+void hang()
+{
+	for(;;){
+		count = count + 1;
+		if(count == limit)break;
+	}
+}
+
+int main()
+{
+	int r;
+	spin();
+	hang();
+	r = spin();
+	return r * 10 + count;
+}
@@ -0,0 +1,22 @@
+int x = 3, y = 5;
+
+// Every relational operator stored as a value, main returns 42
+int main()
+{
+	int r = 0, t;
+
+	t = x < y;
+	r = r * 2 + t;
+	t = x > y;
+	r = r * 2 + t;
+	t = x <= x;
+	r = r * 2 + t;
+	t = x >= y;
+	r = r * 2 + t;
+	t = x == y;
+	r = r * 2 + t + (x != y);
+	t = y < x;
+	r = r * 2 + t;
+
+	return r;
+}
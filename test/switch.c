@@ -0,0 +1,23 @@
+int x = 7;
+
+// Switches without case labels, main returns 12
+int main()
+{
+	int r = 0, i;
+
+	switch(x){
+	default:
+		r = r + 10;
+	}
+	switch(x){
+	}
+	for(i = 0; i < 2; i++){
+		switch(i){
+		default:
+			r = r + 1;
+			break;
+		}
+	}
+
+	return r;
+}